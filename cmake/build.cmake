@@ -62,6 +62,11 @@ else()
     CODE_FILE "${_wayland_protocols_src_dir}/presentation-time-protocol.c"
     HEADER_FILE "${_wayland_protocols_src_dir}/presentation-time-protocol.h")
 
+  generate_wayland_client_protocol(
+    PROTOCOL_FILE "${_wayland_protocols_xml_dir}/stable/viewporter/viewporter.xml"
+    CODE_FILE "${_wayland_protocols_src_dir}/viewporter-protocol.c"
+    HEADER_FILE "${_wayland_protocols_src_dir}/viewporter-client-protocol.h")
+
   add_definitions(-DFLUTTER_TARGET_BACKEND_WAYLAND)
   add_definitions(-DDISPLAY_BACKEND_TYPE_WAYLAND)
   set(DISPLAY_BACKEND_SRC
@@ -69,6 +74,7 @@ else()
     "${_wayland_protocols_src_dir}/text-input-unstable-v1-protocol.c"
     "${_wayland_protocols_src_dir}/text-input-unstable-v3-protocol.c"
     "${_wayland_protocols_src_dir}/presentation-time-protocol.c"
+    "${_wayland_protocols_src_dir}/viewporter-protocol.c"
     "src/flutter/shell/platform/linux_embedded/window/elinux_window_wayland.cc"
     "src/flutter/shell/platform/linux_embedded/window/native_window_wayland.cc"
     "src/flutter/shell/platform/linux_embedded/window/native_window_wayland_decoration.cc"
@@ -78,6 +84,38 @@ else()
     "src/flutter/shell/platform/linux_embedded/window/renderer/window_decoration_button.cc"
     "src/flutter/shell/platform/linux_embedded/window/renderer/window_decoration_titlebar.cc"
     "src/flutter/shell/platform/linux_embedded/window/renderer/window_decorations_wayland.cc")
+
+  # fractional-scale-v1 was added in wayland-protocols 1.31. Without it, the
+  # window is rendered at the integer scale of the output.
+  if(WAYLAND_PROTOCOLS_VERSION VERSION_LESS "1.31")
+    message(WARNING "wayland-protocols ${WAYLAND_PROTOCOLS_VERSION} is older than 1.31, fractional scaling is disabled")
+  else()
+    generate_wayland_client_protocol(
+      PROTOCOL_FILE "${_wayland_protocols_xml_dir}/staging/fractional-scale/fractional-scale-v1.xml"
+      CODE_FILE "${_wayland_protocols_src_dir}/fractional-scale-v1-protocol.c"
+      HEADER_FILE "${_wayland_protocols_src_dir}/fractional-scale-v1-client-protocol.h")
+    add_definitions(-DUSE_WAYLAND_FRACTIONAL_SCALE)
+    list(APPEND DISPLAY_BACKEND_SRC
+      "${_wayland_protocols_src_dir}/fractional-scale-v1-protocol.c")
+  endif()
+endif()
+
+# Buffers allocated by the embedder on Wayland.
+if(USE_WAYLAND_DMABUF)
+  if(NOT ${BACKEND_TYPE} STREQUAL "WAYLAND")
+    message(FATAL_ERROR "USE_WAYLAND_DMABUF is only supported by the WAYLAND backend")
+  endif()
+  if(USE_VULKAN)
+    message(FATAL_ERROR "USE_WAYLAND_DMABUF can't be used with USE_VULKAN")
+  endif()
+  generate_wayland_client_protocol(
+    PROTOCOL_FILE "${_wayland_protocols_xml_dir}/unstable/linux-dmabuf/linux-dmabuf-unstable-v1.xml"
+    CODE_FILE "${_wayland_protocols_src_dir}/linux-dmabuf-unstable-v1-protocol.c"
+    HEADER_FILE "${_wayland_protocols_src_dir}/linux-dmabuf-unstable-v1-client-protocol.h")
+  add_definitions(-DUSE_WAYLAND_DMABUF)
+  list(APPEND DISPLAY_BACKEND_SRC
+    "${_wayland_protocols_src_dir}/linux-dmabuf-unstable-v1-protocol.c"
+    "src/flutter/shell/platform/linux_embedded/window/native_window_wayland_dmabuf.cc")
 endif()
 
 # OpenGL ES version.
@@ -85,6 +123,14 @@ if(USE_GLES3)
   add_definitions(-DUSE_GLES3)
 endif()
 
+# Vulkan renderer. It replaces OpenGL ES at build time. The other backends are
+# rejected in CMakeLists.txt.
+if(USE_VULKAN)
+  add_definitions(-DUSE_VULKAN)
+  list(APPEND DISPLAY_BACKEND_SRC
+    "src/flutter/shell/platform/linux_embedded/surface/surface_vulkan.cc")
+endif()
+
 # Flutter embedder runtime mode.
 if(FLUTTER_RELEASE)
   add_definitions(
@@ -99,6 +145,13 @@ if(ENABLE_ELINUX_EMBEDDER_LOG)
   )
 endif()
 
+# Enable heap allocation tracker of eLinux embedder.
+if(ENABLE_ELINUX_ALLOCATION_TRACKER)
+  add_definitions(
+    -DENABLE_ELINUX_ALLOCATION_TRACKER
+  )
+endif()
+
 # Enable embedder vsync.
 if(ENABLE_VSYNC)
   add_definitions(
@@ -126,6 +179,7 @@ set(CPP_WRAPPER_SOURCES_APP
 )
 
 set(ELINUX_COMMON_SRC
+  "src/flutter/shell/platform/linux_embedded/allocation_tracker.cc"
   "src/flutter/shell/platform/linux_embedded/flutter_elinux.cc"
   "src/flutter/shell/platform/linux_embedded/flutter_elinux_engine.cc"
   "src/flutter/shell/platform/linux_embedded/flutter_elinux_view.cc"
@@ -133,9 +187,14 @@ set(ELINUX_COMMON_SRC
   "src/flutter/shell/platform/linux_embedded/task_runner.cc"
   "src/flutter/shell/platform/linux_embedded/system_utils.cc"
   "src/flutter/shell/platform/linux_embedded/logger.cc"
+  "src/flutter/shell/platform/linux_embedded/external_texture_gl.cc"
   "src/flutter/shell/platform/linux_embedded/external_texture_pixelbuffer.cc"
+  "src/flutter/shell/platform/linux_embedded/external_texture_compressed.cc"
   "src/flutter/shell/platform/linux_embedded/vsync_waiter.cc"
   "src/flutter/shell/platform/linux_embedded/flutter_elinux_texture_registrar.cc"
+  "src/flutter/shell/platform/linux_embedded/texture_pool.cc"
+  "src/flutter/shell/platform/linux_embedded/texture_downscaler.cc"
+  "src/flutter/shell/platform/linux_embedded/texture_decoder.cc"
   "src/flutter/shell/platform/linux_embedded/plugins/keyboard_glfw_util.cc"
   "src/flutter/shell/platform/linux_embedded/plugins/key_event_plugin.cc"
   "src/flutter/shell/platform/linux_embedded/plugins/lifecycle_plugin.cc"
@@ -145,6 +204,7 @@ set(ELINUX_COMMON_SRC
   "src/flutter/shell/platform/linux_embedded/plugins/platform_views_plugin.cc"
   "src/flutter/shell/platform/linux_embedded/plugins/text_input_plugin.cc"
   "src/flutter/shell/platform/linux_embedded/surface/context_egl.cc"
+  "src/flutter/shell/platform/linux_embedded/surface/context_egl_shared.cc"
   "src/flutter/shell/platform/linux_embedded/surface/egl_utils.cc"
   "src/flutter/shell/platform/linux_embedded/surface/elinux_egl_surface.cc"
   "src/flutter/shell/platform/linux_embedded/surface/surface_base.cc"
@@ -157,6 +217,7 @@ set(ELINUX_COMMON_SRC
   ## Following files were imported from:
   ## https://github.com/flutter/engine/tree/master/shell/platform/common
   "src/flutter/shell/platform/common/text_input_model.cc"
+  "src/flutter/shell/platform/common/utf_converter.cc"
   "src/flutter/shell/platform/common/json_message_codec.cc"
   "src/flutter/shell/platform/common/json_method_codec.cc"
   "src/flutter/shell/platform/common/engine_switches.cc"
@@ -218,6 +279,7 @@ target_include_directories(${TARGET}
     ${LIBSYSTEMD_INCLUDE_DIRS}
     ${X11_INCLUDE_DIRS}
     ${LIBWESTON_INCLUDE_DIRS}
+    ${VULKAN_INCLUDE_DIRS}
     ## User libraries
     ${USER_APP_INCLUDE_DIRS}
 )
@@ -236,6 +298,7 @@ target_link_libraries(${TARGET}
     ${LIBSYSTEMD_LIBRARIES}
     ${X11_LIBRARIES}
     ${LIBWESTON_LIBRARIES}
+    ${VULKAN_LIBRARIES}
     ${FLUTTER_EMBEDDER_LIB}
     ## User libraries
     ${USER_APP_LIBRARIES}
@@ -28,8 +28,17 @@ else()
   pkg_check_modules(WAYLAND_CLIENT REQUIRED wayland-client>=1.16.0)
   pkg_check_modules(WAYLAND_CURSOR REQUIRED wayland-cursor>=1.16.0)
   pkg_check_modules(WAYLAND_EGL REQUIRED wayland-egl>=1.16.0)
+  if(USE_WAYLAND_DMABUF)
+    pkg_check_modules(DRM REQUIRED libdrm>=2.4.109)
+    pkg_check_modules(GBM REQUIRED gbm)
+  endif()
 endif()
 
 # requires for supporting external texture plugin.
 # OpenGL ES3 are included in glesv2.
 pkg_check_modules(GLES REQUIRED glesv2)
+
+# requires for the Vulkan renderer.
+if(USE_VULKAN)
+  pkg_check_modules(VULKAN REQUIRED vulkan)
+endif()
@@ -21,12 +21,17 @@ class FlutterEmbedderOptions {
     options_.AddInt("rotation", "r",
                     "Window rotation(degree) [0(default)|90|180|270]", 0,
                     false);
+    options_.AddWithoutValue("display-rotation", "t",
+                             "Let the display hardware apply the rotation",
+                             false);
     options_.AddDouble("force-scale-factor", "s",
                     "Force a scale factor instead using default value", 1.0,
                     false);
 #if defined(FLUTTER_TARGET_BACKEND_GBM) || \
     defined(FLUTTER_TARGET_BACKEND_EGLSTREAM)
-    // no more options.
+    options_.AddWithoutValue("variable-refresh-rate", "v",
+                             "Enable variable refresh rate of the display",
+                             false);
 #elif defined(FLUTTER_TARGET_BACKEND_X11)
     options_.AddWithoutValue("fullscreen", "f", "Always full-screen display",
                              false);
@@ -75,6 +80,8 @@ class FlutterEmbedderOptions {
       }
     }
 
+    use_display_rotation_ = options_.Exist("display-rotation");
+
     if (options_.Exist("force-scale-factor")) {
       is_force_scale_factor_ = true;
       scale_factor_ = options_.GetValue<double>("force-scale-factor");
@@ -87,6 +94,7 @@ class FlutterEmbedderOptions {
     defined(FLUTTER_TARGET_BACKEND_EGLSTREAM)
     use_onscreen_keyboard_ = false;
     use_window_decoration_ = false;
+    use_variable_refresh_rate_ = options_.Exist("variable-refresh-rate");
     window_view_mode_ = flutter::FlutterViewController::ViewMode::kFullscreen;
 #elif defined(FLUTTER_TARGET_BACKEND_X11)
     use_onscreen_keyboard_ = false;
@@ -123,6 +131,8 @@ class FlutterEmbedderOptions {
   flutter::FlutterViewController::ViewRotation WindowRotation() const {
     return window_view_rotation_;
   }
+  bool IsUseDisplayRotation() const { return use_display_rotation_; }
+  bool IsUseVariableRefreshRate() const { return use_variable_refresh_rate_; }
   bool IsForceScaleFactor() const { return is_force_scale_factor_; }
   double ScaleFactor() const { return scale_factor_; }
 
@@ -139,6 +149,8 @@ class FlutterEmbedderOptions {
   int window_height_ = 720;
   flutter::FlutterViewController::ViewRotation window_view_rotation_ =
       flutter::FlutterViewController::ViewRotation::kRotation_0;
+  bool use_display_rotation_ = false;
+  bool use_variable_refresh_rate_ = false;
   bool is_force_scale_factor_;
   double scale_factor_;
 };
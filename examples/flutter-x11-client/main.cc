@@ -30,6 +30,9 @@ int main(int argc, char** argv) {
   view_properties.height = options.WindowHeight();
   view_properties.view_mode = options.WindowViewMode();
   view_properties.view_rotation = options.WindowRotation();
+  view_properties.use_display_rotation = options.IsUseDisplayRotation();
+  view_properties.use_variable_refresh_rate =
+      options.IsUseVariableRefreshRate();
   view_properties.use_mouse_cursor = options.IsUseMouseCursor();
   view_properties.use_onscreen_keyboard = options.IsUseOnscreenKeyboard();
   view_properties.use_window_decoration = options.IsUseWindowDecoraation();
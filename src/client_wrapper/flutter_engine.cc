@@ -29,6 +29,10 @@ FlutterEngine::FlutterEngine(const DartProject& project) {
       static_cast<int>(entrypoint_argv.size());
   c_engine_properties.dart_entrypoint_argv =
       entrypoint_argv.size() > 0 ? entrypoint_argv.data() : nullptr;
+  c_engine_properties.dart_old_gen_heap_size = project.dart_old_gen_heap_size();
+  c_engine_properties.texture_memory_budget = project.texture_memory_budget();
+  c_engine_properties.downscale_external_textures =
+      project.downscale_external_textures();
 
   engine_ = FlutterDesktopEngineCreate(c_engine_properties);
 
@@ -68,6 +72,20 @@ std::chrono::nanoseconds FlutterEngine::ProcessMessages() {
   return std::chrono::nanoseconds(FlutterDesktopEngineProcessMessages(engine_));
 }
 
+std::vector<int> FlutterEngine::GetPollFds() {
+  std::vector<int> fds(FlutterDesktopEngineGetPollFds(engine_, nullptr, 0));
+  fds.resize(FlutterDesktopEngineGetPollFds(engine_, fds.data(), fds.size()));
+  return fds;
+}
+
+std::chrono::nanoseconds FlutterEngine::GetNextTimeout() {
+  auto timeout = FlutterDesktopEngineGetNextTimeout(engine_);
+  if (timeout == UINT64_MAX) {
+    return std::chrono::nanoseconds::max();
+  }
+  return std::chrono::nanoseconds(timeout);
+}
+
 void FlutterEngine::ReloadSystemFonts() {
   FlutterDesktopEngineReloadSystemFonts(engine_);
 }
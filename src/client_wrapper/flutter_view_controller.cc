@@ -25,6 +25,9 @@ FlutterViewController::FlutterViewController(
                 : (view_properties.view_rotation == ViewRotation::kRotation_270)
                       ? FlutterDesktopViewRotation::kRotation_270
                       : FlutterDesktopViewRotation::kRotation_0;
+  c_view_properties.use_display_rotation = view_properties.use_display_rotation;
+  c_view_properties.use_variable_refresh_rate =
+      view_properties.use_variable_refresh_rate;
   c_view_properties.view_mode =
       (view_properties.view_mode == ViewMode::kFullscreen)
           ? FlutterDesktopViewMode::kFullscreen
@@ -48,6 +51,26 @@ FlutterViewController::FlutterViewController(
       FlutterDesktopViewControllerGetView(controller_));
 }
 
+bool FlutterViewController::ReplaceEngine(const DartProject& project) {
+  if (!controller_) {
+    return false;
+  }
+  auto engine = std::make_unique<FlutterEngine>(project);
+  bool result = FlutterDesktopViewControllerReplaceEngine(
+      controller_, engine->RelinquishEngine());
+  if (!result) {
+    // The controller can't be used without an engine anymore.
+    std::cerr << "Failed to replace the engine." << std::endl;
+    view_ = nullptr;
+    FlutterDesktopViewControllerDestroy(controller_);
+    controller_ = nullptr;
+    engine_ = nullptr;
+    return false;
+  }
+  engine_ = std::move(engine);
+  return true;
+}
+
 FlutterViewController::~FlutterViewController() {
   if (controller_) {
     FlutterDesktopViewControllerDestroy(controller_);
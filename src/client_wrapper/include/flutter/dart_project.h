@@ -5,6 +5,7 @@
 #ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_CLIENT_WRAPPER_INCLUDE_FLUTTER_DART_PROJECT_H_
 #define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_CLIENT_WRAPPER_INCLUDE_FLUTTER_DART_PROJECT_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,36 @@ class DartProject {
     return dart_entrypoint_arguments_;
   }
 
+  // Sets the max size of the Dart old gen heap in MB. 0 keeps the Dart VM's
+  // default, and kFlutterDesktopDartOldGenHeapSizeAuto derives it from the
+  // memory available to the process.
+  void set_dart_old_gen_heap_size(int64_t size) {
+    dart_old_gen_heap_size_ = size;
+  }
+
+  // Returns the max size of the Dart old gen heap in MB.
+  int64_t dart_old_gen_heap_size() const { return dart_old_gen_heap_size_; }
+
+  // Sets the budget in MB of the GPU memory used by external textures. 0
+  // means no limit.
+  void set_texture_memory_budget(int64_t size) {
+    texture_memory_budget_ = size;
+  }
+
+  // Returns the budget of the external texture memory in MB.
+  int64_t texture_memory_budget() const { return texture_memory_budget_; }
+
+  // Sets whether pixel buffer textures much larger than displayed are
+  // downscaled on the GPU.
+  void set_downscale_external_textures(bool downscale) {
+    downscale_external_textures_ = downscale;
+  }
+
+  // Returns whether oversized pixel buffer textures are downscaled.
+  bool downscale_external_textures() const {
+    return downscale_external_textures_;
+  }
+
  private:
   // Accessors for internals are private, so that they can be changed if more
   // flexible options for project structures are needed later without it
@@ -63,6 +94,12 @@ class DartProject {
   std::wstring aot_library_path_;
   // The list of arguments to pass through to the Dart entrypoint.
   std::vector<std::string> dart_entrypoint_arguments_;
+  // The max size of the Dart old gen heap in MB.
+  int64_t dart_old_gen_heap_size_ = 0;
+  // The budget of the external texture memory in MB.
+  int64_t texture_memory_budget_ = 0;
+  // Whether oversized pixel buffer textures are downscaled on the GPU.
+  bool downscale_external_textures_ = false;
 };
 
 }  // namespace flutter
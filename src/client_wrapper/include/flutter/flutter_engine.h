@@ -10,6 +10,7 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "binary_messenger.h"
 #include "dart_project.h"
@@ -53,6 +54,15 @@ class FlutterEngine : public PluginRegistry {
   // last return value from this function.
   std::chrono::nanoseconds ProcessMessages();
 
+  // Returns the file descriptors to wait on when driving the engine from an
+  // existing event loop. See FlutterDesktopEngineGetPollFds for details.
+  std::vector<int> GetPollFds();
+
+  // Returns the delay until the next scheduled event, or
+  // std::chrono::nanoseconds::max() if none is scheduled, without processing
+  // anything.
+  std::chrono::nanoseconds GetNextTimeout();
+
   // Tells the engine that the system font list has changed. Should be called
   // by clients when OS-level font changes happen (e.g., WM_FONTCHANGE in a
   // Win32 application).
@@ -54,6 +54,12 @@ class FlutterViewController {
     // View rotation.
     ViewRotation view_rotation;
 
+    // Lets the display hardware apply the view rotation if possible.
+    bool use_display_rotation;
+
+    // Enables the variable refresh rate of the display if possible.
+    bool use_variable_refresh_rate;
+
     // View display mode. If you set kFullscreen, the parameters of both `width`
     // and `height` will be ignored.
     ViewMode view_mode;
@@ -89,6 +95,15 @@ class FlutterViewController {
   // Returns the engine running Flutter content in this view.
   FlutterEngine* engine() { return engine_.get(); }
 
+  // Shuts down the current engine and runs |project| in this view with a new
+  // one, keeping the view and its display. Pointers returned by engine() are
+  // invalidated, and plugins have to be registered again with the new engine.
+  //
+  // Returns false if the new engine couldn't be started. The view has then
+  // been destroyed, like when creating this controller fails: view() and
+  // engine() return nullptr.
+  bool ReplaceEngine(const DartProject& project);
+
   // Returns the view managed by this controller.
   FlutterView* view() { return view_.get(); }
 
@@ -8,12 +8,17 @@
 #include <flutter_messenger.h>
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include "include/flutter/binary_messenger.h"
 
 namespace flutter {
 
+namespace internal {
+class ReplySlotPool;
+}  // namespace internal
+
 // Wrapper around a FlutterDesktopMessengerRef that implements the
 // BinaryMessenger API.
 class BinaryMessengerImpl : public BinaryMessenger {
@@ -43,6 +48,10 @@ class BinaryMessengerImpl : public BinaryMessenger {
   // A map from channel names to the BinaryMessageHandler that should be called
   // for incoming messages on that channel.
   std::map<std::string, BinaryMessageHandler> handlers_;
+
+  // Reusable holders for the replies of in-flight Send() calls. Shared with
+  // the slots, since a reply may arrive after this object is destroyed.
+  std::shared_ptr<internal::ReplySlotPool> reply_slot_pool_;
 };
 
 }  // namespace flutter
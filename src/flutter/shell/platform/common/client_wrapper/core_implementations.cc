@@ -15,7 +15,9 @@
 
 #include <cassert>
 #include <iostream>
+#include <mutex>
 #include <variant>
+#include <vector>
 
 #include "binary_messenger_impl.h"
 #include "include/flutter/engine_method_result.h"
@@ -36,6 +38,8 @@ void ForwardToHandler(FlutterDesktopMessengerRef messenger,
                       const FlutterDesktopMessage* message,
                       void* user_data) {
   auto* response_handle = message->response_handle;
+  // Only two pointers are captured, so the reply fits in std::function's
+  // inline storage and isn't heap allocated.
   BinaryReply reply_handler = [messenger, response_handle](
                                   const uint8_t* reply,
                                   size_t reply_size) mutable {
@@ -60,9 +64,64 @@ void ForwardToHandler(FlutterDesktopMessengerRef messenger,
 }
 }  // namespace
 
+namespace internal {
+
+// A pool of reply holders, so that Send() doesn't allocate one for each reply
+// and moves the reply instead of copying it. This doesn't make Send()
+// allocation free: a BinaryReply whose captures don't fit std::function's
+// inline storage is still allocated by the caller when it's built. Replies
+// may be sent from any thread, so access is locked.
+class ReplySlotPool : public std::enable_shared_from_this<ReplySlotPool> {
+ public:
+  struct Slot {
+    BinaryReply reply;
+    // Keeps the pool alive while the reply is in flight.
+    std::shared_ptr<ReplySlotPool> pool;
+  };
+
+  Slot* Acquire(BinaryReply reply) {
+    std::unique_ptr<Slot> slot;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_slots_.empty()) {
+        slot = std::move(free_slots_.back());
+        free_slots_.pop_back();
+      }
+    }
+    if (!slot) {
+      slot = std::make_unique<Slot>();
+    }
+    slot->reply = std::move(reply);
+    slot->pool = shared_from_this();
+    return slot.release();
+  }
+
+  static void Release(Slot* slot) {
+    std::unique_ptr<Slot> owned_slot(slot);
+    owned_slot->reply = nullptr;
+    // Drop the slot's reference only after it's back in the pool, which may
+    // then be destroyed along with it.
+    auto pool = std::move(owned_slot->pool);
+    std::lock_guard<std::mutex> lock(pool->mutex_);
+    if (pool->free_slots_.size() < kMaxFreeSlots) {
+      pool->free_slots_.push_back(std::move(owned_slot));
+    }
+  }
+
+ private:
+  // Bounds what is kept around after a burst of concurrent requests.
+  static constexpr size_t kMaxFreeSlots = 32;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Slot>> free_slots_;
+};
+
+}  // namespace internal
+
 BinaryMessengerImpl::BinaryMessengerImpl(
     FlutterDesktopMessengerRef core_messenger)
-    : messenger_(core_messenger) {}
+    : messenger_(core_messenger),
+      reply_slot_pool_(std::make_shared<internal::ReplySlotPool>()) {}
 
 BinaryMessengerImpl::~BinaryMessengerImpl() = default;
 
@@ -75,23 +134,20 @@ void BinaryMessengerImpl::Send(const std::string& channel,
                                 message_size);
     return;
   }
-  struct Captures {
-    BinaryReply reply;
-  };
-  auto captures = new Captures();
-  captures->reply = reply;
+  using Slot = internal::ReplySlotPool::Slot;
+  // |reply| is moved rather than copied, so its captures stay where they are.
+  Slot* slot = reply_slot_pool_->Acquire(std::move(reply));
 
   auto message_reply = [](const uint8_t* data, size_t data_size,
                           void* user_data) {
-    auto captures = reinterpret_cast<Captures*>(user_data);
-    captures->reply(data, data_size);
-    delete captures;
+    auto slot = reinterpret_cast<Slot*>(user_data);
+    slot->reply(data, data_size);
+    internal::ReplySlotPool::Release(slot);
   };
   bool result = FlutterDesktopMessengerSendWithReply(
-      messenger_, channel.c_str(), message, message_size, message_reply,
-      captures);
+      messenger_, channel.c_str(), message, message_size, message_reply, slot);
   if (!result) {
-    delete captures;
+    internal::ReplySlotPool::Release(slot);
   }
 }
 
@@ -85,7 +85,10 @@ class TextureRegistrar {
  public:
   virtual ~TextureRegistrar() = default;
 
-  // Registers a |texture| object and returns the ID for that texture.
+  // Registers a |texture| object and returns the ID for that texture, or -1
+  // if it can't be registered. Embedders built with USE_VULKAN reject every
+  // texture, because the engine only populates external textures with the
+  // OpenGL ES renderer.
   virtual int64_t RegisterTexture(TextureVariant* texture) = 0;
 
   // Notifies the flutter engine that the texture object corresponding
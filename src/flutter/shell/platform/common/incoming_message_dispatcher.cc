@@ -17,23 +17,24 @@ void IncomingMessageDispatcher::HandleMessage(
     const FlutterDesktopMessage& message,
     const std::function<void(void)>& input_block_cb,
     const std::function<void(void)>& input_unblock_cb) {
-  std::string channel(message.channel);
-
   // Find the handler for the channel; if there isn't one, report the failure.
-  if (callbacks_.find(channel) == callbacks_.end()) {
+  auto it = channels_.find(std::string_view(message.channel));
+  if (it == channels_.end() || !it->second->callback) {
     FlutterDesktopMessengerSendResponse(messenger_, message.response_handle,
                                         nullptr, 0);
     return;
   }
-  auto& callback_info = callbacks_[channel];
-  FlutterDesktopMessageCallback message_callback = callback_info.first;
+  const ChannelEntry& entry = *it->second;
+  FlutterDesktopMessageCallback message_callback = entry.callback;
+  void* user_data = entry.user_data;
 
-  // Process the call, handling input blocking if requested.
-  bool block_input = input_blocking_channels_.count(channel) > 0;
+  // Process the call, handling input blocking if requested. |entry| isn't
+  // used after the callback, which may unregister itself.
+  bool block_input = entry.block_input;
   if (block_input) {
     input_block_cb();
   }
-  message_callback(messenger_, &message, callback_info.second);
+  message_callback(messenger_, &message, user_data);
   if (block_input) {
     input_unblock_cb();
   }
@@ -44,15 +45,38 @@ void IncomingMessageDispatcher::SetMessageCallback(
     FlutterDesktopMessageCallback callback,
     void* user_data) {
   if (!callback) {
-    callbacks_.erase(channel);
+    auto it = channels_.find(channel);
+    if (it == channels_.end()) {
+      return;
+    }
+    if (it->second->block_input) {
+      it->second->callback = nullptr;
+      it->second->user_data = nullptr;
+    } else {
+      channels_.erase(it);
+    }
     return;
   }
-  callbacks_[channel] = std::make_pair(callback, user_data);
+  auto& entry = GetOrCreateEntry(channel);
+  entry.callback = callback;
+  entry.user_data = user_data;
 }
 
 void IncomingMessageDispatcher::EnableInputBlockingForChannel(
     const std::string& channel) {
-  input_blocking_channels_.insert(channel);
+  GetOrCreateEntry(channel).block_input = true;
+}
+
+IncomingMessageDispatcher::ChannelEntry&
+IncomingMessageDispatcher::GetOrCreateEntry(const std::string& channel) {
+  auto it = channels_.find(channel);
+  if (it != channels_.end()) {
+    return *it->second;
+  }
+  auto entry = std::make_unique<ChannelEntry>();
+  entry->name = channel;
+  std::string_view key(entry->name);
+  return *channels_.emplace(key, std::move(entry)).first->second;
 }
 
 }  // namespace flutter
@@ -6,10 +6,10 @@
 #define FLUTTER_SHELL_PLATFORM_CPP_INCOMING_MESSAGE_DISPATCHER_H_
 
 #include <functional>
-#include <map>
-#include <set>
+#include <memory>
 #include <string>
-#include <utility>
+#include <string_view>
+#include <unordered_map>
 
 #include "flutter/shell/platform/common/public/flutter_messenger.h"
 
@@ -59,18 +59,26 @@ class IncomingMessageDispatcher {
   void EnableInputBlockingForChannel(const std::string& channel);
 
  private:
+  // The routing state of a channel. The map below is keyed by views into
+  // |name|, so incoming channel names are looked up without a copy.
+  struct ChannelEntry {
+    std::string name;
+    FlutterDesktopMessageCallback callback = nullptr;
+    void* user_data = nullptr;
+    // Whether input should be blocked while the handler for this channel runs.
+    bool block_input = false;
+  };
+
+  // Returns the entry for |channel|, creating it if needed.
+  ChannelEntry& GetOrCreateEntry(const std::string& channel);
+
   // Handle for interacting with the C messaging API.
   FlutterDesktopMessengerRef messenger_;
 
-  // A map from channel names to the FlutterDesktopMessageCallback that should
-  // be called for incoming messages on that channel, along with the void* user
-  // data to pass to it.
-  std::map<std::string, std::pair<FlutterDesktopMessageCallback, void*>>
-      callbacks_;
-
-  // Channel names for which input blocking should be enabled during the call to
-  // that channel's handler.
-  std::set<std::string> input_blocking_channels_;
+  // A map from channel names to their callbacks and input blocking state.
+  // Entries without a callback are kept only while input blocking is enabled.
+  std::unordered_map<std::string_view, std::unique_ptr<ChannelEntry>>
+      channels_;
 };
 
 }  // namespace flutter
@@ -51,6 +51,12 @@ typedef void (*FlutterDesktopMessageCallback)(
     void* /* user data */);
 
 // Sends a binary message to the Flutter side on the specified channel.
+//
+// This may be called from any thread. A message sent from a thread other than
+// the platform thread is sent later by the platform thread; true only means
+// it was queued, and any reply is delivered on the platform thread. If the
+// engine is stopped before a queued message is sent, |reply| is called with no
+// data so that |user_data| can be released.
 FLUTTER_EXPORT bool FlutterDesktopMessengerSend(
     FlutterDesktopMessengerRef messenger,
     const char* channel,
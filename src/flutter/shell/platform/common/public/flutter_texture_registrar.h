@@ -38,6 +38,12 @@ typedef enum {
   kFlutterDesktopGpuSurfaceTypeDxgiSharedHandle,
   // A |ID3D11Texture2D| (Windows only).
   kFlutterDesktopGpuSurfaceTypeD3d11Texture2D,
+  // A |FlutterDesktopGlTexture| rendered with a shared GL context (eLinux
+  // only). See flutter_elinux.h.
+  kFlutterDesktopGpuSurfaceTypeGlTexture,
+  // A |FlutterDesktopCompressedPixelBuffer| uploaded by the embedder (eLinux
+  // only). See flutter_elinux.h.
+  kFlutterDesktopGpuSurfaceTypeCompressedPixelBuffer,
 } FlutterDesktopGpuSurfaceType;
 
 // Supported pixel formats.
@@ -76,7 +82,9 @@ typedef struct {
   //
   // Provide a |ID3D11Texture2D*| when using
   // |kFlutterDesktopGpuSurfaceTypeD3d11Texture2D| or a |HANDLE| when using
-  // |kFlutterDesktopGpuSurfaceTypeDxgiSharedHandle|.
+  // |kFlutterDesktopGpuSurfaceTypeDxgiSharedHandle|, or a
+  // |FlutterDesktopGlTexture*| when using
+  // |kFlutterDesktopGpuSurfaceTypeGlTexture|.
   //
   // The referenced resource needs to stay valid until it has been opened by
   // Flutter. Consider incrementing the resource's reference count in the
@@ -157,6 +165,9 @@ typedef struct {
 } FlutterDesktopTextureInfo;
 
 // Registers a new texture with the Flutter engine and returns the texture ID.
+// Returns -1 if the texture can't be registered. Embedders built with
+// USE_VULKAN reject every texture, because the engine only populates external
+// textures with the OpenGL ES renderer.
 // This function can be called from any thread.
 FLUTTER_EXPORT int64_t FlutterDesktopTextureRegistrarRegisterExternalTexture(
     FlutterDesktopTextureRegistrarRef texture_registrar,
@@ -5,14 +5,9 @@
 #include "flutter/shell/platform/common/text_input_model.h"
 
 #include <algorithm>
-#include <codecvt>
-#include <locale>
+#include <string_view>
 
-#if defined(_MSC_VER)
-// TODO(naifu): This temporary code is to solve link error.(VS2015/2017)
-// https://social.msdn.microsoft.com/Forums/vstudio/en-US/8f40dcd8-c67f-4eba-9134-a19b9178e481/vs-2015-rc-linker-stdcodecvt-error
-std::locale::id std::codecvt<char16_t, char, _Mbstatet>::id;
-#endif  // defined(_MSC_VER)
+#include "flutter/shell/platform/common/utf_converter.h"
 
 namespace flutter {
 
@@ -34,9 +29,7 @@ TextInputModel::TextInputModel() = default;
 TextInputModel::~TextInputModel() = default;
 
 void TextInputModel::SetText(const std::string& text) {
-  std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>
-      utf16_converter;
-  text_ = utf16_converter.from_bytes(text);
+  text_ = Utf16FromUtf8(text);
   selection_ = TextRange(0);
   composing_range_ = TextRange(0);
 }
@@ -79,9 +72,7 @@ void TextInputModel::UpdateComposingText(const std::u16string& text) {
 }
 
 void TextInputModel::UpdateComposingText(const std::string& text) {
-  std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>
-      utf16_converter;
-  UpdateComposingText(utf16_converter.from_bytes(text));
+  UpdateComposingText(Utf16FromUtf8(text));
 }
 
 void TextInputModel::CommitComposing() {
@@ -140,9 +131,7 @@ void TextInputModel::AddText(const std::u16string& text) {
 }
 
 void TextInputModel::AddText(const std::string& text) {
-  std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>
-      utf16_converter;
-  AddText(utf16_converter.from_bytes(text));
+  AddText(Utf16FromUtf8(text));
 }
 
 bool TextInputModel::Backspace() {
@@ -290,18 +279,42 @@ bool TextInputModel::MoveCursorBack() {
 }
 
 std::string TextInputModel::GetText() const {
-  std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>
-      utf8_converter;
-  return utf8_converter.to_bytes(text_);
+  return Utf8FromUtf16(text_);
 }
 
 int TextInputModel::GetCursorOffset() const {
-  // Measure the length of the current text up to the selection extent.
-  // There is probably a much more efficient way of doing this.
-  auto leading_text = text_.substr(0, selection_.extent());
-  std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>
-      utf8_converter;
-  return utf8_converter.to_bytes(leading_text).size();
+  // Measure the length of the current text up to the selection extent,
+  // without converting it.
+  return Utf8LengthOfUtf16(
+      std::u16string_view(text_).substr(0, selection_.extent()));
+}
+
+std::string TextInputModel::GetSurroundingText(size_t max_context,
+                                               size_t* cursor,
+                                               size_t* anchor) const {
+  size_t base = std::min(selection_.base(), text_.length());
+  size_t extent = std::min(selection_.extent(), text_.length());
+  size_t first = std::min(base, extent);
+  size_t last = std::max(base, extent);
+  if (last - first > max_context) {
+    first = last = extent;
+  }
+  size_t start = first > max_context ? first - max_context : 0;
+  size_t end = std::min(last + max_context, text_.length());
+  // Don't split surrogate pairs at the edges.
+  if (start > 0 && IsTrailingSurrogate(text_.at(start))) {
+    start++;
+  }
+  if (end < text_.length() && IsLeadingSurrogate(text_.at(end - 1))) {
+    end--;
+  }
+  base = std::clamp(base, start, end);
+  extent = std::clamp(extent, start, end);
+
+  std::u16string_view text(text_);
+  *cursor = Utf8LengthOfUtf16(text.substr(start, extent - start));
+  *anchor = Utf8LengthOfUtf16(text.substr(start, base - start));
+  return Utf8FromUtf16(text.substr(start, end - start));
 }
 
 }  // namespace flutter
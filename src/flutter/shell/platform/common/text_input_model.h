@@ -178,6 +178,16 @@ class TextInputModel {
   // GetText().
   int GetCursorOffset() const;
 
+  // Gets the text around the selection as UTF-8, for input methods which
+  // only need the context of the cursor. At most |max_context| UTF-16 code
+  // units are included before and after the selection. If the selection is
+  // longer than |max_context|, the text is centered on the selection extent
+  // instead. |cursor| and |anchor| are set to the byte offsets of the
+  // selection extent and base in the returned text.
+  std::string GetSurroundingText(size_t max_context,
+                                 size_t* cursor,
+                                 size_t* anchor) const;
+
   // Returns a range covering the entire text.
   TextRange text_range() const { return TextRange(0, text_.length()); }
 
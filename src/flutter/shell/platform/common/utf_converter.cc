@@ -0,0 +1,302 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/common/utf_converter.h"
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace flutter {
+
+namespace {
+
+constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+bool IsContinuationByte(uint8_t byte) {
+  return (byte & 0xC0) == 0x80;
+}
+
+bool IsLeadingSurrogate(char16_t unit) {
+  return (unit & 0xFC00) == 0xD800;
+}
+
+bool IsTrailingSurrogate(char16_t unit) {
+  return (unit & 0xFC00) == 0xDC00;
+}
+
+// Widens the ASCII bytes at the start of |src| to |dst|, 16 at a time.
+// Returns the number of bytes converted, a multiple of 16, which is always 0
+// without SSE2 or NEON.
+size_t WidenAscii([[maybe_unused]] const uint8_t* src,
+                  [[maybe_unused]] size_t length,
+                  [[maybe_unused]] char16_t* dst) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8),
+                     _mm_unpackhi_epi8(bytes, zero));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 16 <= length; i += 16) {
+    uint8x16_t bytes = vld1q_u8(src + i);
+    if (vmaxvq_u8(bytes) >= 0x80) {
+      break;
+    }
+    vst1q_u16(reinterpret_cast<uint16_t*>(dst + i),
+              vmovl_u8(vget_low_u8(bytes)));
+    vst1q_u16(reinterpret_cast<uint16_t*>(dst + i + 8),
+              vmovl_high_u8(bytes));
+  }
+#endif
+  return i;
+}
+
+// Narrows the ASCII code units at the start of |src| to |dst|, 16 at a time.
+// Returns the number of code units converted, a multiple of 16.
+size_t NarrowAscii([[maybe_unused]] const char16_t* src,
+                   [[maybe_unused]] size_t length,
+                   [[maybe_unused]] char* dst) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i non_ascii_mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    __m128i non_ascii = _mm_and_si128(_mm_or_si128(low, high), non_ascii_mask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(low, high));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 16 <= length; i += 16) {
+    uint16x8_t low = vld1q_u16(reinterpret_cast<const uint16_t*>(src + i));
+    uint16x8_t high =
+        vld1q_u16(reinterpret_cast<const uint16_t*>(src + i + 8));
+    if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+      break;
+    }
+    vst1q_u8(reinterpret_cast<uint8_t*>(dst + i),
+             vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+#endif
+  return i;
+}
+
+// Counts the ASCII code units at the start of |src|, 16 at a time.
+size_t CountAscii([[maybe_unused]] const char16_t* src,
+                  [[maybe_unused]] size_t length) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i non_ascii_mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    __m128i non_ascii = _mm_and_si128(_mm_or_si128(low, high), non_ascii_mask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF) {
+      break;
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 16 <= length; i += 16) {
+    uint16x8_t low = vld1q_u16(reinterpret_cast<const uint16_t*>(src + i));
+    uint16x8_t high =
+        vld1q_u16(reinterpret_cast<const uint16_t*>(src + i + 8));
+    if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+      break;
+    }
+  }
+#endif
+  return i;
+}
+
+// Decodes the UTF-8 sequence at |src[*index]| and advances |*index| past it.
+// An invalid sequence decodes to U+FFFD and only its first byte is consumed.
+char32_t DecodeUtf8(const uint8_t* src, size_t length, size_t* index) {
+  size_t i = *index;
+  uint8_t lead = src[i];
+  size_t count;
+  char32_t code_point;
+  // Bounds of the second byte, which exclude overlong encodings, surrogates
+  // and code points beyond U+10FFFF.
+  uint8_t min = 0x80;
+  uint8_t max = 0xBF;
+  if (lead < 0x80) {
+    *index = i + 1;
+    return lead;
+  } else if (lead >= 0xC2 && lead <= 0xDF) {
+    count = 2;
+    code_point = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    count = 3;
+    code_point = lead & 0x0F;
+    if (lead == 0xE0) {
+      min = 0xA0;
+    } else if (lead == 0xED) {
+      max = 0x9F;
+    }
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    count = 4;
+    code_point = lead & 0x07;
+    if (lead == 0xF0) {
+      min = 0x90;
+    } else if (lead == 0xF4) {
+      max = 0x8F;
+    }
+  } else {
+    *index = i + 1;
+    return kReplacementCharacter;
+  }
+
+  if (i + count > length || src[i + 1] < min || src[i + 1] > max) {
+    *index = i + 1;
+    return kReplacementCharacter;
+  }
+  for (size_t j = 1; j < count; j++) {
+    if (!IsContinuationByte(src[i + j])) {
+      *index = i + 1;
+      return kReplacementCharacter;
+    }
+    code_point = (code_point << 6) | (src[i + j] & 0x3F);
+  }
+  *index = i + count;
+  return code_point;
+}
+
+// Returns the code point at |src[*index]| and advances |*index| past it. An
+// unpaired surrogate decodes to U+FFFD.
+char32_t DecodeUtf16(const char16_t* src, size_t length, size_t* index) {
+  size_t i = *index;
+  char16_t unit = src[i];
+  if (IsLeadingSurrogate(unit) && i + 1 < length &&
+      IsTrailingSurrogate(src[i + 1])) {
+    *index = i + 2;
+    return 0x10000 + ((static_cast<char32_t>(unit) - 0xD800) << 10) +
+           (src[i + 1] - 0xDC00);
+  }
+  *index = i + 1;
+  if (IsLeadingSurrogate(unit) || IsTrailingSurrogate(unit)) {
+    return kReplacementCharacter;
+  }
+  return unit;
+}
+
+size_t Utf8Length(char32_t code_point) {
+  if (code_point < 0x80) {
+    return 1;
+  } else if (code_point < 0x800) {
+    return 2;
+  } else if (code_point < 0x10000) {
+    return 3;
+  }
+  return 4;
+}
+
+}  // namespace
+
+std::u16string Utf16FromUtf8(std::string_view text) {
+  auto src = reinterpret_cast<const uint8_t*>(text.data());
+  size_t length = text.size();
+  // The UTF-16 text has at most as many code units as the UTF-8 one has
+  // bytes.
+  std::u16string result(length, u'\0');
+  char16_t* dst = result.data();
+  size_t i = 0;
+  size_t out = 0;
+  while (i < length) {
+    if (src[i] < 0x80) {
+      size_t ascii = WidenAscii(src + i, length - i, dst + out);
+      i += ascii;
+      out += ascii;
+      // Finish the run which didn't fill a whole block.
+      while (i < length && src[i] < 0x80) {
+        dst[out++] = src[i++];
+      }
+      continue;
+    }
+    char32_t code_point = DecodeUtf8(src, length, &i);
+    if (code_point >= 0x10000) {
+      code_point -= 0x10000;
+      dst[out++] = static_cast<char16_t>((code_point >> 10) + 0xD800);
+      dst[out++] = static_cast<char16_t>((code_point & 0x3FF) + 0xDC00);
+    } else {
+      dst[out++] = static_cast<char16_t>(code_point);
+    }
+  }
+  result.resize(out);
+  return result;
+}
+
+std::string Utf8FromUtf16(std::u16string_view text) {
+  const char16_t* src = text.data();
+  size_t length = text.size();
+  std::string result(Utf8LengthOfUtf16(text), '\0');
+  char* dst = result.data();
+  size_t i = 0;
+  size_t out = 0;
+  while (i < length) {
+    if (src[i] < 0x80) {
+      size_t ascii = NarrowAscii(src + i, length - i, dst + out);
+      i += ascii;
+      out += ascii;
+      while (i < length && src[i] < 0x80) {
+        dst[out++] = static_cast<char>(src[i++]);
+      }
+      continue;
+    }
+    char32_t code_point = DecodeUtf16(src, length, &i);
+    if (code_point < 0x800) {
+      dst[out++] = static_cast<char>(0xC0 | (code_point >> 6));
+    } else if (code_point < 0x10000) {
+      dst[out++] = static_cast<char>(0xE0 | (code_point >> 12));
+      dst[out++] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    } else {
+      dst[out++] = static_cast<char>(0xF0 | (code_point >> 18));
+      dst[out++] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      dst[out++] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    }
+    dst[out++] = static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+  return result;
+}
+
+size_t Utf8LengthOfUtf16(std::u16string_view text) {
+  const char16_t* src = text.data();
+  size_t length = text.size();
+  size_t i = 0;
+  size_t bytes = 0;
+  while (i < length) {
+    if (src[i] < 0x80) {
+      size_t ascii = CountAscii(src + i, length - i);
+      i += ascii;
+      bytes += ascii;
+      while (i < length && src[i] < 0x80) {
+        i++;
+        bytes++;
+      }
+      continue;
+    }
+    bytes += Utf8Length(DecodeUtf16(src, length, &i));
+  }
+  return bytes;
+}
+
+}  // namespace flutter
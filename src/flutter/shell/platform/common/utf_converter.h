@@ -0,0 +1,31 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_COMMON_UTF_CONVERTER_H_
+#define FLUTTER_SHELL_PLATFORM_COMMON_UTF_CONVERTER_H_
+
+#include <string>
+#include <string_view>
+
+namespace flutter {
+
+// Conversions between UTF-8 and UTF-16 which replace invalid input (malformed
+// or overlong UTF-8 sequences, unpaired surrogates) with U+FFFD instead of
+// throwing like std::wstring_convert. Runs of ASCII, which make up most of
+// the text entered on embedded devices, are converted 16 bytes at a time with
+// SSE2 or NEON when available. The NEON path is only built for aarch64, so
+// 32-bit ARM takes the scalar path.
+
+// Converts |text| from UTF-8 to UTF-16.
+std::u16string Utf16FromUtf8(std::string_view text);
+
+// Converts |text| from UTF-16 to UTF-8.
+std::string Utf8FromUtf16(std::u16string_view text);
+
+// Returns the length in bytes of Utf8FromUtf16(|text|) without converting it.
+size_t Utf8LengthOfUtf16(std::u16string_view text);
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_COMMON_UTF_CONVERTER_H_
@@ -0,0 +1,277 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/allocation_tracker.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include "flutter/shell/platform/linux_embedded/logger.h"
+
+namespace flutter {
+
+namespace {
+
+constexpr int kNoRegion = -1;
+constexpr int kRegionNum = kFlutterDesktopAllocationRegionNum;
+
+// The region of the current thread. This is read from inside malloc, so it
+// must not be lazily allocated by the dynamic TLS machinery, which would
+// recurse into malloc.
+thread_local int current_region __attribute__((tls_model("initial-exec"))) =
+    kNoRegion;
+
+std::atomic<uint64_t> frame_allocation_counts[kRegionNum];
+std::atomic<uint64_t> frame_allocation_bytes[kRegionNum];
+std::atomic<uint64_t> last_frame_allocation_counts[kRegionNum];
+std::atomic<uint64_t> last_frame_allocation_bytes[kRegionNum];
+std::atomic<uint64_t> total_allocation_counts[kRegionNum];
+std::atomic<uint64_t> frame_count;
+std::atomic<uint64_t> allocating_frame_count;
+
+// Regions which run on every frame, even when nothing changes, and so must
+// not allocate once the embedder has warmed up.
+constexpr int kPerFrameRegions[] = {kFlutterDesktopAllocationRegionPresent,
+                                    kFlutterDesktopAllocationRegionVsync};
+
+// Frames after which the per-frame regions are expected to be warmed up, e.g.
+// to have grown their buffers to the sizes they keep.
+constexpr uint64_t kWarmUpFrames = 60;
+
+// Makes the first allocating frame abort the process, so that test runs fail
+// instead of only logging a warning.
+constexpr char kFailOnFrameAllocationEnvironmentKey[] =
+    "FLUTTER_ELINUX_FAIL_ON_FRAME_ALLOCATION";
+
+}  // namespace
+
+bool AllocationTracker::IsEnabled() {
+#if defined(ENABLE_ELINUX_ALLOCATION_TRACKER)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AllocationTracker::RecordAllocation(size_t size) {
+  const int region = current_region;
+  if (region == kNoRegion) {
+    return;
+  }
+  frame_allocation_counts[region].fetch_add(1, std::memory_order_relaxed);
+  frame_allocation_bytes[region].fetch_add(size, std::memory_order_relaxed);
+  total_allocation_counts[region].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationTracker::OnFramePresented() {
+  for (int i = 0; i < kRegionNum; i++) {
+    last_frame_allocation_counts[i].store(
+        frame_allocation_counts[i].exchange(0, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    last_frame_allocation_bytes[i].store(
+        frame_allocation_bytes[i].exchange(0, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+  if (frame_count.fetch_add(1, std::memory_order_relaxed) < kWarmUpFrames) {
+    return;
+  }
+
+  uint64_t per_frame_allocations = 0;
+  for (auto region : kPerFrameRegions) {
+    per_frame_allocations +=
+        last_frame_allocation_counts[region].load(std::memory_order_relaxed);
+  }
+  if (per_frame_allocations > 0 &&
+      allocating_frame_count.fetch_add(1, std::memory_order_relaxed) == 0) {
+    // Only the first one is logged, which would otherwise flood the log.
+    if (std::getenv(kFailOnFrameAllocationEnvironmentKey)) {
+      ELINUX_LOG(FATAL) << "The frame presentation path allocated "
+                        << per_frame_allocations << " times in a frame.";
+    }
+    ELINUX_LOG(WARNING) << "The frame presentation path allocated "
+                        << per_frame_allocations << " times in a frame.";
+  }
+}
+
+void AllocationTracker::GetStats(FlutterDesktopEngineStats* stats) {
+  stats->frame_count = frame_count.load(std::memory_order_relaxed);
+  stats->allocation_tracker_enabled = IsEnabled();
+  for (int i = 0; i < kRegionNum; i++) {
+    stats->last_frame_allocation_counts[i] =
+        last_frame_allocation_counts[i].load(std::memory_order_relaxed);
+    stats->last_frame_allocation_bytes[i] =
+        last_frame_allocation_bytes[i].load(std::memory_order_relaxed);
+    stats->total_allocation_counts[i] =
+        total_allocation_counts[i].load(std::memory_order_relaxed);
+  }
+  stats->allocating_frame_count =
+      allocating_frame_count.load(std::memory_order_relaxed);
+}
+
+ScopedAllocationRegion::ScopedAllocationRegion(
+    FlutterDesktopAllocationRegion region)
+    : previous_region_(current_region) {
+  current_region = static_cast<int>(region);
+}
+
+ScopedAllocationRegion::ScopedAllocationRegion()
+    : previous_region_(current_region) {
+  current_region = kNoRegion;
+}
+
+ScopedAllocationRegion::~ScopedAllocationRegion() {
+  current_region = previous_region_;
+}
+
+}  // namespace flutter
+
+#if defined(ENABLE_ELINUX_ALLOCATION_TRACKER)
+#if defined(__GLIBC__)
+// With glibc, the libc allocation functions are interposed. This also covers
+// operator new of libstdc++/libc++, including the aligned variants, and the C
+// allocators used by rapidjson.
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t nmemb, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+
+void* malloc(size_t size) {
+  flutter::AllocationTracker::RecordAllocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+  // An overflowing request fails in __libc_calloc, so it isn't recorded.
+  size_t bytes;
+  if (!__builtin_mul_overflow(nmemb, size, &bytes)) {
+    flutter::AllocationTracker::RecordAllocation(bytes);
+  }
+  return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  flutter::AllocationTracker::RecordAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  flutter::AllocationTracker::RecordAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  // Like glibc, which doesn't require |size| to be a multiple of
+  // |alignment|.
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  flutter::AllocationTracker::RecordAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+  if (alignment % sizeof(void*) != 0 ||
+      (alignment & (alignment - 1)) != 0 || alignment == 0) {
+    return EINVAL;
+  }
+  flutter::AllocationTracker::RecordAllocation(size);
+  void* ptr = __libc_memalign(alignment, size);
+  if (!ptr) {
+    return ENOMEM;
+  }
+  *memptr = ptr;
+  return 0;
+}
+
+void* valloc(size_t size) {
+  flutter::AllocationTracker::RecordAllocation(size);
+  return __libc_valloc(size);
+}
+
+void* pvalloc(size_t size) {
+  flutter::AllocationTracker::RecordAllocation(size);
+  return __libc_pvalloc(size);
+}
+
+}  // extern "C"
+#else
+// Other C libraries don't expose their internal allocators, so only the C++
+// allocations, including the aligned ones, are accounted.
+void* operator new(size_t size) {
+  flutter::AllocationTracker::RecordAllocation(size);
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  flutter::AllocationTracker::RecordAllocation(size);
+  return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+  return ::operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  flutter::AllocationTracker::RecordAllocation(size);
+  // aligned_alloc requires the size to be a multiple of the alignment.
+  auto align = static_cast<size_t>(alignment);
+  void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return ::operator new(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+#endif
+#endif
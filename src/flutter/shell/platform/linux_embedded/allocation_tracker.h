@@ -0,0 +1,64 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_ALLOCATION_TRACKER_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_ALLOCATION_TRACKER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "flutter/shell/platform/linux_embedded/public/flutter_elinux.h"
+
+namespace flutter {
+
+// Counts heap allocations made inside the embedder's hot-path regions.
+//
+// The counting itself is only active when the embedder is built with
+// ENABLE_ELINUX_ALLOCATION_TRACKER, which interposes the process-wide heap
+// allocation functions. Allocations are only accounted while the calling
+// thread is inside a ScopedAllocationRegion, so that the allocations made by
+// the Flutter engine or by the user application are not counted. The frame
+// bookkeeping is always active. The counters are process-wide, shared by all
+// the engines.
+class AllocationTracker {
+ public:
+  // Returns true if the allocation counting is compiled in.
+  static bool IsEnabled();
+
+  // Records a heap allocation of |size| bytes made by the current thread.
+  static void RecordAllocation(size_t size);
+
+  // Closes the current frame: the counters of the current frame become the
+  // counters of the last frame. Warns the first time that the regions which
+  // run on every frame allocated after the warm-up frames, or aborts if the
+  // FLUTTER_ELINUX_FAIL_ON_FRAME_ALLOCATION environment variable is set.
+  static void OnFramePresented();
+
+  // Fills the allocation fields of |stats|.
+  static void GetStats(FlutterDesktopEngineStats* stats);
+};
+
+// Accounts the heap allocations of the current thread to |region| while this
+// object is alive. Regions may be nested; the innermost one wins.
+class ScopedAllocationRegion {
+ public:
+  explicit ScopedAllocationRegion(FlutterDesktopAllocationRegion region);
+
+  // Stops accounting the allocations of the current thread, e.g. while the
+  // engine runs one of its own tasks from an embedder region.
+  ScopedAllocationRegion();
+
+  ~ScopedAllocationRegion();
+
+  // Prevent copying.
+  ScopedAllocationRegion(ScopedAllocationRegion const&) = delete;
+  ScopedAllocationRegion& operator=(ScopedAllocationRegion const&) = delete;
+
+ private:
+  int previous_region_;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_ALLOCATION_TRACKER_H_
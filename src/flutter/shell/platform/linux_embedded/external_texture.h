@@ -29,6 +29,25 @@ typedef void (*glTexImage2DProc)(GLenum target,
                                  GLenum format,
                                  GLenum type,
                                  const void* data);
+typedef void (*glTexSubImage2DProc)(GLenum target,
+                                    GLint level,
+                                    GLint xoffset,
+                                    GLint yoffset,
+                                    GLsizei width,
+                                    GLsizei height,
+                                    GLenum format,
+                                    GLenum type,
+                                    const void* data);
+typedef void (*glCompressedTexImage2DProc)(GLenum target,
+                                           GLint level,
+                                           GLenum internalformat,
+                                           GLsizei width,
+                                           GLsizei height,
+                                           GLint border,
+                                           GLsizei imageSize,
+                                           const void* data);
+typedef void (*glGetIntegervProc)(GLenum pname, GLint* data);
+typedef const GLubyte* (*glGetStringProc)(GLenum name);
 
 // A struct containing pointers to resolved gl* functions.
 struct GlProcs {
@@ -37,6 +56,10 @@ struct GlProcs {
   glBindTextureProc glBindTexture;
   glTexParameteriProc glTexParameteri;
   glTexImage2DProc glTexImage2D;
+  glTexSubImage2DProc glTexSubImage2D;
+  glCompressedTexImage2DProc glCompressedTexImage2D;
+  glGetIntegervProc glGetIntegerv;
+  glGetStringProc glGetString;
   bool valid;
 };
 
@@ -54,6 +77,15 @@ class ExternalTexture {
   virtual bool PopulateTexture(size_t width,
                                size_t height,
                                FlutterOpenGLTexture* opengl_texture) = 0;
+
+  // Returns the estimated size in bytes of the GPU storage of this texture
+  // when it was last populated.
+  virtual size_t GetStorageBytes() const = 0;
+
+  // Frees the GPU storage of this texture if it can be created again the next
+  // time the texture is populated. Must be called on the raster thread.
+  // Returns the number of bytes freed.
+  virtual size_t EvictStorage() { return 0; }
 };
 
 }  // namespace flutter
@@ -0,0 +1,148 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/external_texture_compressed.h"
+
+#include <vector>
+
+#include "flutter/shell/platform/linux_embedded/flutter_elinux_texture_registrar.h"
+#include "flutter/shell/platform/linux_embedded/logger.h"
+#include "flutter/shell/platform/linux_embedded/texture_decoder.h"
+
+namespace flutter {
+
+namespace {
+#ifdef USE_GLES3
+constexpr uint32_t kDecodedFormat = GL_RGBA8;
+#else
+constexpr uint32_t kDecodedFormat = GL_RGBA8_OES;
+#endif
+}  // namespace
+
+ExternalTextureCompressed::ExternalTextureCompressed(
+    FlutterDesktopGpuSurfaceTextureCallback texture_callback,
+    void* user_data,
+    const GlProcs& gl_procs,
+    FlutterELinuxTextureRegistrar* registrar)
+    : texture_callback_(texture_callback),
+      user_data_(user_data),
+      gl_(gl_procs),
+      registrar_(registrar) {}
+
+ExternalTextureCompressed::~ExternalTextureCompressed() {
+  if (gl_texture_ != 0) {
+    gl_.glDeleteTextures(1, &gl_texture_);
+  }
+}
+
+size_t ExternalTextureCompressed::GetStorageBytes() const {
+  return gl_texture_ != 0 ? storage_bytes_ : 0;
+}
+
+size_t ExternalTextureCompressed::EvictStorage() {
+  auto bytes = GetStorageBytes();
+  if (gl_texture_ != 0) {
+    gl_.glDeleteTextures(1, &gl_texture_);
+    gl_texture_ = 0;
+    format_ = 0;
+    width_ = 0;
+    height_ = 0;
+  }
+  return bytes;
+}
+
+bool ExternalTextureCompressed::PopulateTexture(
+    size_t width,
+    size_t height,
+    FlutterOpenGLTexture* opengl_texture) {
+  const FlutterDesktopGpuSurfaceDescriptor* descriptor =
+      texture_callback_(width, height, user_data_);
+  if (!descriptor || !descriptor->handle) {
+    return false;
+  }
+
+  auto buffer =
+      static_cast<const FlutterDesktopCompressedPixelBuffer*>(descriptor->handle);
+  bool valid = true;
+  if (buffer->struct_size != sizeof(FlutterDesktopCompressedPixelBuffer)) {
+    ELINUX_LOG(ERROR) << "Invalid compressed pixel buffer struct size.";
+    valid = false;
+  } else if (!buffer->data || buffer->data_size == 0 ||
+             descriptor->width == 0 || descriptor->height == 0) {
+    ELINUX_LOG(ERROR) << "Invalid compressed pixel buffer.";
+    valid = false;
+  }
+
+  if (valid) {
+    valid = Upload(buffer, descriptor->width, descriptor->height);
+  }
+  if (descriptor->release_callback) {
+    descriptor->release_callback(descriptor->release_context);
+  }
+  if (!valid) {
+    return false;
+  }
+
+  // Populate the texture object used by the engine.
+  opengl_texture->target = GL_TEXTURE_2D;
+  opengl_texture->name = gl_texture_;
+  opengl_texture->format = format_;
+  opengl_texture->destruction_callback = nullptr;
+  opengl_texture->user_data = nullptr;
+  opengl_texture->width = descriptor->width;
+  opengl_texture->height = descriptor->height;
+  return true;
+}
+
+bool ExternalTextureCompressed::Upload(
+    const FlutterDesktopCompressedPixelBuffer* buffer,
+    size_t width,
+    size_t height) {
+  if (registrar_->IsCompressedFormatSupported(buffer->format)) {
+    BindTexture();
+    gl_.glCompressedTexImage2D(GL_TEXTURE_2D, 0, buffer->format, width, height,
+                               0, buffer->data_size, buffer->data);
+    format_ = buffer->format;
+    width_ = width;
+    height_ = height;
+    storage_bytes_ = buffer->data_size;
+    return true;
+  }
+
+  std::vector<uint8_t> pixels;
+  if (!DecodeCompressedTexture(buffer->format, buffer->data, buffer->data_size,
+                               width, height, &pixels)) {
+    ELINUX_LOG(ERROR) << "Unsupported compressed pixel buffer format: "
+                      << buffer->format;
+    return false;
+  }
+  BindTexture();
+  if (format_ == kDecodedFormat && width_ == width && height_ == height) {
+    gl_.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+                        GL_UNSIGNED_BYTE, pixels.data());
+  } else {
+    gl_.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, pixels.data());
+    format_ = kDecodedFormat;
+    width_ = width;
+    height_ = height;
+    storage_bytes_ = width * height * 4;
+  }
+  return true;
+}
+
+void ExternalTextureCompressed::BindTexture() {
+  if (gl_texture_ != 0) {
+    gl_.glBindTexture(GL_TEXTURE_2D, gl_texture_);
+    return;
+  }
+  gl_.glGenTextures(1, &gl_texture_);
+  gl_.glBindTexture(GL_TEXTURE_2D, gl_texture_);
+  gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+}  // namespace flutter
@@ -0,0 +1,69 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_EXTERNAL_TEXTURE_COMPRESSED_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_EXTERNAL_TEXTURE_COMPRESSED_H_
+
+#include <stdint.h>
+
+#include "flutter/shell/platform/common/public/flutter_texture_registrar.h"
+#include "flutter/shell/platform/linux_embedded/public/flutter_elinux.h"
+
+#include "flutter/shell/platform/linux_embedded/external_texture.h"
+
+namespace flutter {
+
+class FlutterELinuxTextureRegistrar;
+
+// An abstraction of a texture whose pixels are provided pre-compressed (e.g.
+// ETC2 or ASTC) by a plugin. Formats the GPU supports are uploaded as is, so
+// the texture takes the compressed size in GPU memory. The others are decoded
+// to RGBA on the CPU, if there is a software decoder for them.
+class ExternalTextureCompressed : public ExternalTexture {
+ public:
+  ExternalTextureCompressed(
+      FlutterDesktopGpuSurfaceTextureCallback texture_callback,
+      void* user_data,
+      const GlProcs& gl_procs,
+      FlutterELinuxTextureRegistrar* registrar);
+
+  virtual ~ExternalTextureCompressed();
+
+  // |ExternalTexture|
+  bool PopulateTexture(size_t width,
+                       size_t height,
+                       FlutterOpenGLTexture* opengl_texture) override;
+
+  // |ExternalTexture|
+  size_t GetStorageBytes() const override;
+
+  // |ExternalTexture|
+  size_t EvictStorage() override;
+
+ private:
+  // Uploads |buffer| of |width| x |height| pixels to |gl_texture_|, decoding
+  // it first if the GPU doesn't support its format. Returns false on error.
+  bool Upload(const FlutterDesktopCompressedPixelBuffer* buffer,
+              size_t width,
+              size_t height);
+
+  // Binds |gl_texture_|, creating it first if needed.
+  void BindTexture();
+
+  FlutterDesktopGpuSurfaceTextureCallback texture_callback_ = nullptr;
+  void* const user_data_ = nullptr;
+  const GlProcs& gl_;
+  FlutterELinuxTextureRegistrar* const registrar_ = nullptr;
+  GLuint gl_texture_ = 0;
+  // The GL internal format of |gl_texture_|: the compressed format, or RGBA if
+  // the data was decoded.
+  uint32_t format_ = 0;
+  size_t width_ = 0;
+  size_t height_ = 0;
+  size_t storage_bytes_ = 0;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_EXTERNAL_TEXTURE_COMPRESSED_H_
@@ -0,0 +1,97 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/external_texture_gl.h"
+
+#include "flutter/shell/platform/linux_embedded/logger.h"
+#include "flutter/shell/platform/linux_embedded/public/flutter_elinux.h"
+#include "flutter/shell/platform/linux_embedded/surface/egl_utils.h"
+
+namespace flutter {
+
+void ExternalTextureGl::WaitAndDestroyFence(EGLSyncKHR fence) {
+  EGLDisplay display = eglGetCurrentDisplay();
+  if (display != egl_display_) {
+    egl_display_ = display;
+    egl_sync_procs_ = {};
+    if (has_egl_extension(display, "EGL_KHR_fence_sync")) {
+      egl_sync_procs_.eglClientWaitSyncKHR =
+          reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+              eglGetProcAddress("eglClientWaitSyncKHR"));
+      egl_sync_procs_.eglDestroySyncKHR =
+          reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+              eglGetProcAddress("eglDestroySyncKHR"));
+      if (has_egl_extension(display, "EGL_KHR_wait_sync")) {
+        egl_sync_procs_.eglWaitSyncKHR =
+            reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(
+                eglGetProcAddress("eglWaitSyncKHR"));
+      }
+    }
+  }
+
+  const auto& egl = egl_sync_procs_;
+  if (egl.eglWaitSyncKHR) {
+    // GPU-side wait: doesn't block the raster thread.
+    if (egl.eglWaitSyncKHR(display, fence, 0) != EGL_TRUE) {
+      ELINUX_LOG(WARNING) << "Failed to wait on the texture fence.";
+    }
+  } else if (egl.eglClientWaitSyncKHR) {
+    egl.eglClientWaitSyncKHR(display, fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
+                             EGL_FOREVER_KHR);
+  }
+  if (egl.eglDestroySyncKHR) {
+    egl.eglDestroySyncKHR(display, fence);
+  }
+}
+
+ExternalTextureGl::ExternalTextureGl(
+    FlutterDesktopGpuSurfaceTextureCallback texture_callback,
+    void* user_data)
+    : texture_callback_(texture_callback), user_data_(user_data) {}
+
+bool ExternalTextureGl::PopulateTexture(size_t width,
+                                        size_t height,
+                                        FlutterOpenGLTexture* opengl_texture) {
+  const FlutterDesktopGpuSurfaceDescriptor* descriptor =
+      texture_callback_(width, height, user_data_);
+  if (!descriptor || !descriptor->handle) {
+    return false;
+  }
+
+  auto gl_texture = static_cast<FlutterDesktopGlTexture*>(descriptor->handle);
+  if (gl_texture->struct_size != sizeof(FlutterDesktopGlTexture)) {
+    ELINUX_LOG(ERROR) << "Invalid GL texture struct size.";
+    if (descriptor->release_callback) {
+      descriptor->release_callback(descriptor->release_context);
+    }
+    return false;
+  }
+
+  if (gl_texture->fence) {
+    WaitAndDestroyFence(static_cast<EGLSyncKHR>(gl_texture->fence));
+  }
+
+  // Populate the texture object used by the engine.
+  opengl_texture->target =
+      gl_texture->target ? gl_texture->target : GL_TEXTURE_2D;
+  opengl_texture->name = gl_texture->name;
+#ifdef USE_GLES3
+  opengl_texture->format = gl_texture->format ? gl_texture->format : GL_RGBA8;
+#else
+  opengl_texture->format =
+      gl_texture->format ? gl_texture->format : GL_RGBA8_OES;
+#endif
+  opengl_texture->destruction_callback = nullptr;
+  opengl_texture->user_data = nullptr;
+  opengl_texture->width = descriptor->visible_width;
+  opengl_texture->height = descriptor->visible_height;
+  storage_bytes_ = descriptor->visible_width * descriptor->visible_height * 4;
+
+  if (descriptor->release_callback) {
+    descriptor->release_callback(descriptor->release_context);
+  }
+  return true;
+}
+
+}  // namespace flutter
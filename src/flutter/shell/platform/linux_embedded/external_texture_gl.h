@@ -0,0 +1,61 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_EXTERNAL_TEXTURE_GL_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_EXTERNAL_TEXTURE_GL_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdint.h>
+
+#include "flutter/shell/platform/common/public/flutter_texture_registrar.h"
+
+#include "flutter/shell/platform/linux_embedded/external_texture.h"
+
+namespace flutter {
+
+// An abstraction of a GL texture rendered by a plugin with a shared context.
+// No pixels are copied: the plugin's texture is handed to the engine as is,
+// after the embedder has waited on the fence published with the frame.
+class ExternalTextureGl : public ExternalTexture {
+ public:
+  ExternalTextureGl(FlutterDesktopGpuSurfaceTextureCallback texture_callback,
+                    void* user_data);
+
+  virtual ~ExternalTextureGl() = default;
+
+  // |ExternalTexture|
+  bool PopulateTexture(size_t width,
+                       size_t height,
+                       FlutterOpenGLTexture* opengl_texture) override;
+
+  // |ExternalTexture|
+  size_t GetStorageBytes() const override { return storage_bytes_; }
+
+ private:
+  struct EglSyncProcs {
+    PFNEGLWAITSYNCKHRPROC eglWaitSyncKHR;
+    PFNEGLCLIENTWAITSYNCKHRPROC eglClientWaitSyncKHR;
+    PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR;
+  };
+
+  // Makes the commands issued on the current context wait for |fence|, then
+  // destroys it.
+  void WaitAndDestroyFence(EGLSyncKHR fence);
+
+  FlutterDesktopGpuSurfaceTextureCallback texture_callback_ = nullptr;
+  void* const user_data_ = nullptr;
+  // The texture is owned by the plugin, so its size is estimated from the
+  // visible size as RGBA.
+  size_t storage_bytes_ = 0;
+  // The functions of the sync extensions supported by |egl_display_|. The
+  // engines of a process can use different displays, so they are looked up
+  // again if the current display changes.
+  EGLDisplay egl_display_ = EGL_NO_DISPLAY;
+  EglSyncProcs egl_sync_procs_ = {};
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_EXTERNAL_TEXTURE_GL_H_
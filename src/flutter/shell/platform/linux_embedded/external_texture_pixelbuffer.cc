@@ -4,25 +4,83 @@
 
 #include "flutter/shell/platform/linux_embedded/external_texture_pixelbuffer.h"
 
+#include <algorithm>
+
 namespace flutter {
 
+namespace {
+// The size hint is rounded up to this granularity, so that producers don't
+// reallocate their buffers on every frame of a resize animation.
+constexpr size_t kSizeHintAlignment = 64;
+
+// Buffers are downscaled when they have more than this many times the pixels
+// of the displayed texture. Below that, one upload is cheaper than the extra
+// pass.
+constexpr size_t kDownscaleMinRatio = 2;
+
+size_t AlignSize(size_t size) {
+  return (size + kSizeHintAlignment - 1) / kSizeHintAlignment *
+         kSizeHintAlignment;
+}
+
+// Returns the hint of an axis, which grows right away but only shrinks once
+// the displayed size is clearly smaller.
+size_t UpdateAxisHint(size_t hint, size_t size) {
+  if (size == 0) {
+    return hint;
+  }
+  if (size > hint || size < hint * 3 / 4) {
+    return AlignSize(size);
+  }
+  return hint;
+}
+}  // namespace
+
 struct ExternalTexturePixelBufferState {
   GLuint gl_texture = 0;
+  // Size of the storage of |gl_texture|.
+  size_t width = 0;
+  size_t height = 0;
+
+  // Size passed to the texture callback.
+  size_t hint_width = 0;
+  size_t hint_height = 0;
 };
 
 ExternalTexturePixelBuffer::ExternalTexturePixelBuffer(
     FlutterDesktopPixelBufferTextureCallback texture_callback,
     void* user_data,
-    const GlProcs& gl_procs)
+    const GlProcs& gl_procs,
+    TexturePool* texture_pool,
+    TextureDownscaler* downscaler)
     : state_(std::make_unique<ExternalTexturePixelBufferState>()),
       texture_callback_(texture_callback),
       user_data_(user_data),
-      gl_(gl_procs) {}
+      gl_(gl_procs),
+      texture_pool_(texture_pool),
+      downscaler_(downscaler) {}
 
 ExternalTexturePixelBuffer::~ExternalTexturePixelBuffer() {
+  ReleaseTexture(state_->gl_texture, state_->width, state_->height);
+}
+
+size_t ExternalTexturePixelBuffer::GetStorageBytes() const {
+  if (state_->gl_texture == 0) {
+    return 0;
+  }
+  return state_->width * state_->height * 4;
+}
+
+size_t ExternalTexturePixelBuffer::EvictStorage() {
+  auto bytes = GetStorageBytes();
+  // Deleted rather than pooled: the point is to free the memory.
   if (state_->gl_texture != 0) {
     gl_.glDeleteTextures(1, &state_->gl_texture);
+    state_->gl_texture = 0;
+    state_->width = 0;
+    state_->height = 0;
   }
+  return bytes;
 }
 
 bool ExternalTexturePixelBuffer::PopulateTexture(
@@ -51,32 +109,142 @@ bool ExternalTexturePixelBuffer::PopulateTexture(
 
 bool ExternalTexturePixelBuffer::CopyPixelBuffer(size_t& width,
                                                  size_t& height) {
-  const FlutterDesktopPixelBuffer* pixel_buffer =
-      texture_callback_(width, height, user_data_);
+  auto display_width = width;
+  auto display_height = height;
+  UpdateSizeHint(display_width, display_height);
+  const FlutterDesktopPixelBuffer* pixel_buffer = texture_callback_(
+      state_->hint_width > 0 ? state_->hint_width : width,
+      state_->hint_height > 0 ? state_->hint_height : height, user_data_);
   if (!pixel_buffer || !pixel_buffer->buffer) {
     return false;
   }
   width = pixel_buffer->width;
   height = pixel_buffer->height;
 
+  bool downscaled = false;
+  if (downscaler_ && display_width > 0 && display_height > 0 &&
+      width * height > display_width * display_height * kDownscaleMinRatio) {
+    downscaled = DownscalePixelBuffer(pixel_buffer, width, height);
+  }
+  if (!downscaled) {
+    if (state_->gl_texture == 0 && texture_pool_) {
+      state_->gl_texture = texture_pool_->Acquire(width, height);
+      if (state_->gl_texture != 0) {
+        state_->width = width;
+        state_->height = height;
+      }
+    }
+    UploadPixelBuffer(pixel_buffer, state_->gl_texture, state_->width,
+                      state_->height);
+  }
+  if (pixel_buffer->release_callback) {
+    pixel_buffer->release_callback(pixel_buffer->release_context);
+  }
+  return true;
+}
+
+void ExternalTexturePixelBuffer::UpdateSizeHint(size_t width, size_t height) {
+  state_->hint_width = UpdateAxisHint(state_->hint_width, width);
+  state_->hint_height = UpdateAxisHint(state_->hint_height, height);
+}
+
+bool ExternalTexturePixelBuffer::DownscalePixelBuffer(
+    const FlutterDesktopPixelBuffer* buffer,
+    size_t& width,
+    size_t& height) {
+  // The hint is used instead of the displayed size so that the texture isn't
+  // reallocated while the displayed size animates.
+  auto target_width = std::min(state_->hint_width, buffer->width);
+  auto target_height = std::min(state_->hint_height, buffer->height);
+
+  // The staging texture is only held for the downscale, and then returned
+  // to the pool for the next frame or another texture of the same size.
+  GLuint staging_texture = 0;
+  size_t staging_width = 0;
+  size_t staging_height = 0;
+  if (texture_pool_) {
+    staging_texture = texture_pool_->Acquire(buffer->width, buffer->height);
+    if (staging_texture != 0) {
+      staging_width = buffer->width;
+      staging_height = buffer->height;
+    }
+  }
+  UploadPixelBuffer(buffer, staging_texture, staging_width, staging_height);
+
+  if (state_->gl_texture == 0 && texture_pool_) {
+    state_->gl_texture = texture_pool_->Acquire(target_width, target_height);
+    if (state_->gl_texture != 0) {
+      state_->width = target_width;
+      state_->height = target_height;
+    }
+  }
   if (state_->gl_texture == 0) {
     gl_.glGenTextures(1, &state_->gl_texture);
-
     gl_.glBindTexture(GL_TEXTURE_2D, state_->gl_texture);
     gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  } else {
+  }
+  if (state_->width != target_width || state_->height != target_height) {
     gl_.glBindTexture(GL_TEXTURE_2D, state_->gl_texture);
+    gl_.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, target_width, target_height,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    state_->width = target_width;
+    state_->height = target_height;
   }
-  gl_.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pixel_buffer->width,
-                   pixel_buffer->height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                   pixel_buffer->buffer);
-  if (pixel_buffer->release_callback) {
-    pixel_buffer->release_callback(pixel_buffer->release_context);
+
+  auto downscaled =
+      downscaler_->Downscale(staging_texture, buffer->width, buffer->height,
+                             state_->gl_texture, target_width, target_height);
+  ReleaseTexture(staging_texture, staging_width, staging_height);
+  if (!downscaled) {
+    return false;
   }
+  width = target_width;
+  height = target_height;
   return true;
 }
 
+void ExternalTexturePixelBuffer::ReleaseTexture(GLuint texture,
+                                                size_t width,
+                                                size_t height) {
+  if (texture == 0) {
+    return;
+  }
+  if (texture_pool_ && width > 0 && height > 0) {
+    texture_pool_->Release(texture, width, height);
+  } else {
+    gl_.glDeleteTextures(1, &texture);
+  }
+}
+
+void ExternalTexturePixelBuffer::UploadPixelBuffer(
+    const FlutterDesktopPixelBuffer* buffer,
+    GLuint& texture,
+    size_t& texture_width,
+    size_t& texture_height) {
+  if (texture == 0) {
+    gl_.glGenTextures(1, &texture);
+
+    gl_.glBindTexture(GL_TEXTURE_2D, texture);
+    gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl_.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  } else {
+    gl_.glBindTexture(GL_TEXTURE_2D, texture);
+  }
+  // The storage is only allocated when the size changes.
+  if (texture_width == buffer->width && texture_height == buffer->height) {
+    gl_.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, buffer->width, buffer->height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, buffer->buffer);
+  } else {
+    gl_.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, buffer->width, buffer->height,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, buffer->buffer);
+    texture_width = buffer->width;
+    texture_height = buffer->height;
+  }
+}
+
 }  // namespace flutter
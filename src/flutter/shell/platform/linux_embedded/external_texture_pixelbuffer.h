@@ -12,18 +12,27 @@
 #include "flutter/shell/platform/common/public/flutter_texture_registrar.h"
 
 #include "flutter/shell/platform/linux_embedded/external_texture.h"
+#include "flutter/shell/platform/linux_embedded/texture_downscaler.h"
+#include "flutter/shell/platform/linux_embedded/texture_pool.h"
 
 namespace flutter {
 
 typedef struct ExternalTexturePixelBufferState ExternalTexturePixelBufferState;
 
 // An abstraction of an pixel-buffer based texture.
+//
+// The callback receives a hint of the displayed size, which only changes
+// when the displayed size moves noticeably, so that producers can render
+// frames of that size. Buffers which are still much larger than displayed are
+// downscaled by |downscaler| if it isn't nullptr.
 class ExternalTexturePixelBuffer : public ExternalTexture {
  public:
   ExternalTexturePixelBuffer(
       FlutterDesktopPixelBufferTextureCallback texture_callback,
       void* user_data,
-      const GlProcs& gl_procs);
+      const GlProcs& gl_procs,
+      TexturePool* texture_pool,
+      TextureDownscaler* downscaler);
 
   virtual ~ExternalTexturePixelBuffer();
 
@@ -32,6 +41,12 @@ class ExternalTexturePixelBuffer : public ExternalTexture {
                        size_t height,
                        FlutterOpenGLTexture* opengl_texture) override;
 
+  // |ExternalTexture|
+  size_t GetStorageBytes() const override;
+
+  // |ExternalTexture|
+  size_t EvictStorage() override;
+
  private:
   // Attempts to copy the pixel buffer returned by |texture_callback_| to
   // OpenGL.
@@ -41,10 +56,33 @@ class ExternalTexturePixelBuffer : public ExternalTexture {
   // by |texture_callback_| was invalid.
   bool CopyPixelBuffer(size_t& width, size_t& height);
 
+  // Updates the size hint passed to |texture_callback_| from the size the
+  // engine draws the texture at.
+  void UpdateSizeHint(size_t width, size_t height);
+
+  // Uploads |buffer| into a staging texture and downscales it into the
+  // texture used by the engine, whose size is set to |width| x |height|.
+  // Returns false if it failed, in which case the buffer is uploaded as is.
+  bool DownscalePixelBuffer(const FlutterDesktopPixelBuffer* buffer,
+                            size_t& width,
+                            size_t& height);
+
+  // Returns |texture| of |width| x |height| to the pool, or deletes it if
+  // there is no pool.
+  void ReleaseTexture(GLuint texture, size_t width, size_t height);
+
+  // Binds |texture|, or a new one if it's 0, and uploads |buffer| to it.
+  void UploadPixelBuffer(const FlutterDesktopPixelBuffer* buffer,
+                         GLuint& texture,
+                         size_t& texture_width,
+                         size_t& texture_height);
+
   std::unique_ptr<ExternalTexturePixelBufferState> state_;
   FlutterDesktopPixelBufferTextureCallback texture_callback_ = nullptr;
   void* const user_data_ = nullptr;
   const GlProcs& gl_;
+  TexturePool* texture_pool_;
+  TextureDownscaler* downscaler_;
 };
 
 }  // namespace flutter
@@ -4,6 +4,7 @@
 
 #include "flutter/shell/platform/linux_embedded/public/flutter_elinux.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <memory>
@@ -14,6 +15,7 @@
 #include "flutter/shell/platform/linux_embedded/flutter_elinux_engine.h"
 #include "flutter/shell/platform/linux_embedded/flutter_elinux_state.h"
 #include "flutter/shell/platform/linux_embedded/flutter_elinux_view.h"
+#include "flutter/shell/platform/linux_embedded/surface/context_egl_shared.h"
 #include "flutter/shell/platform/linux_embedded/window_binding_handler.h"
 
 #if defined(DISPLAY_BACKEND_TYPE_DRM_GBM)
@@ -52,6 +54,18 @@ static FlutterDesktopViewRef HandleForView(flutter::FlutterELinuxView* view) {
   return reinterpret_cast<FlutterDesktopViewRef>(view);
 }
 
+// Returns the shared GL context corresponding to the given opaque API handle.
+static flutter::ContextEglShared* GlContextFromHandle(
+    FlutterDesktopGlContextRef ref) {
+  return reinterpret_cast<flutter::ContextEglShared*>(ref);
+}
+
+// Returns the opaque API handle for the given shared GL context instance.
+static FlutterDesktopGlContextRef HandleForGlContext(
+    flutter::ContextEglShared* context) {
+  return reinterpret_cast<FlutterDesktopGlContextRef>(context);
+}
+
 // Returns the texture registrar corresponding to the given opaque API handle.
 static flutter::FlutterELinuxTextureRegistrar* TextureRegistrarFromHandle(
     FlutterDesktopTextureRegistrarRef ref) {
@@ -71,9 +85,35 @@ uint64_t FlutterDesktopEngineProcessMessages(FlutterDesktopEngineRef engine) {
       .count();
 }
 
+size_t FlutterDesktopEngineGetPollFds(FlutterDesktopEngineRef engine,
+                                      int* fds,
+                                      size_t fds_size) {
+  auto engine_fds = EngineFromHandle(engine)->GetPollFds();
+  if (fds) {
+    std::copy_n(engine_fds.begin(), std::min(fds_size, engine_fds.size()),
+                fds);
+  }
+  return engine_fds.size();
+}
+
+uint64_t FlutterDesktopEngineGetNextTimeout(FlutterDesktopEngineRef engine) {
+  auto timeout = static_cast<flutter::TaskRunner*>(
+                     EngineFromHandle(engine)->task_runner())
+                     ->GetNextTimeout();
+  if (timeout == std::chrono::nanoseconds::max()) {
+    return UINT64_MAX;
+  }
+  return timeout.count();
+}
+
 FlutterDesktopViewControllerRef FlutterDesktopViewControllerCreate(
     const FlutterDesktopViewProperties& view_properties,
     FlutterDesktopEngineRef engine) {
+  // Take ownership of the engine first, so that it's destroyed if creating the
+  // view fails.
+  std::unique_ptr<flutter::FlutterELinuxEngine> engine_owner(
+      EngineFromHandle(engine));
+
   std::unique_ptr<flutter::WindowBindingHandler> window_wrapper =
 
 #if defined(DISPLAY_BACKEND_TYPE_DRM_GBM)
@@ -96,9 +136,8 @@ FlutterDesktopViewControllerRef FlutterDesktopViewControllerCreate(
     return nullptr;
   }
 
-  // Take ownership of the engine, starting it if necessary.
-  state->view->SetEngine(
-      std::unique_ptr<flutter::FlutterELinuxEngine>(EngineFromHandle(engine)));
+  // Start the engine if necessary.
+  state->view->SetEngine(std::move(engine_owner));
   if (!state->view->GetEngine()->running()) {
     if (!state->view->GetEngine()->RunWithEntrypoint(nullptr)) {
       return nullptr;
@@ -110,6 +149,24 @@ FlutterDesktopViewControllerRef FlutterDesktopViewControllerCreate(
   return state.release();
 }
 
+bool FlutterDesktopViewControllerReplaceEngine(
+    FlutterDesktopViewControllerRef controller,
+    FlutterDesktopEngineRef engine) {
+  auto* view = controller->view.get();
+  view->ReplaceEngine(
+      std::unique_ptr<flutter::FlutterELinuxEngine>(EngineFromHandle(engine)));
+  if (!view->GetEngine()->running()) {
+    if (!view->GetEngine()->RunWithEntrypoint(nullptr)) {
+      // The previous engine is already gone, so there is nothing to go back
+      // to. Leave the view without an engine.
+      view->ReplaceEngine(nullptr);
+      return false;
+    }
+  }
+  view->SendInitialBounds();
+  return true;
+}
+
 void FlutterDesktopViewControllerDestroy(
     FlutterDesktopViewControllerRef controller) {
   delete controller;
@@ -180,6 +237,15 @@ FlutterDesktopTextureRegistrarRef FlutterDesktopEngineGetTextureRegistrar(
       EngineFromHandle(engine)->texture_registrar());
 }
 
+bool FlutterDesktopEngineGetStats(FlutterDesktopEngineRef engine,
+                                  FlutterDesktopEngineStats* stats) {
+  if (!stats || stats->struct_size != sizeof(FlutterDesktopEngineStats)) {
+    return false;
+  }
+  EngineFromHandle(engine)->GetStats(stats);
+  return true;
+}
+
 FlutterDesktopViewRef FlutterDesktopPluginRegistrarGetView(
     FlutterDesktopPluginRegistrarRef registrar) {
   return HandleForView(registrar->engine->view());
@@ -258,6 +324,50 @@ bool FlutterDesktopTextureRegistrarMarkExternalTextureFrameAvailable(
       ->MarkTextureFrameAvailable(texture_id);
 }
 
+bool FlutterDesktopTextureRegistrarPostRasterThreadTask(
+    FlutterDesktopTextureRegistrarRef texture_registrar,
+    void (*callback)(void* user_data),
+    void* user_data) {
+  return TextureRegistrarFromHandle(texture_registrar)
+      ->PostRasterThreadTask(callback, user_data);
+}
+
+bool FlutterDesktopTextureRegistrarIsCompressedFormatSupported(
+    FlutterDesktopTextureRegistrarRef texture_registrar,
+    uint32_t format) {
+  return TextureRegistrarFromHandle(texture_registrar)
+      ->IsCompressedFormatSupported(format);
+}
+
+FlutterDesktopGlContextRef FlutterDesktopTextureRegistrarCreateSharedGlContext(
+    FlutterDesktopTextureRegistrarRef texture_registrar) {
+  return HandleForGlContext(TextureRegistrarFromHandle(texture_registrar)
+                                ->CreateSharedGlContext()
+                                .release());
+}
+
+void FlutterDesktopGlContextDestroy(FlutterDesktopGlContextRef context) {
+  delete GlContextFromHandle(context);
+}
+
+bool FlutterDesktopGlContextMakeCurrent(FlutterDesktopGlContextRef context) {
+  return GlContextFromHandle(context)->MakeCurrent();
+}
+
+bool FlutterDesktopGlContextClearCurrent(FlutterDesktopGlContextRef context) {
+  return GlContextFromHandle(context)->ClearCurrent();
+}
+
+void* FlutterDesktopGlContextGetProcAddress(FlutterDesktopGlContextRef context,
+                                            const char* name) {
+  return GlContextFromHandle(context)->GlProcResolver(name);
+}
+
+void* FlutterDesktopGlContextCreateFence(FlutterDesktopGlContextRef context) {
+  EGLSyncKHR fence = GlContextFromHandle(context)->CreateFence();
+  return fence == EGL_NO_SYNC_KHR ? nullptr : fence;
+}
+
 void FlutterDesktopRegisterPlatformViewFactory(
     FlutterDesktopPluginRegistrarRef registrar,
     const char* view_type,
@@ -6,12 +6,14 @@
 
 #include <rapidjson/document.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
 #include "flutter/shell/platform/common/client_wrapper/binary_messenger_impl.h"
 #include "flutter/shell/platform/common/client_wrapper/include/flutter/basic_message_channel.h"
 #include "flutter/shell/platform/common/json_message_codec.h"
+#include "flutter/shell/platform/linux_embedded/allocation_tracker.h"
 #include "flutter/shell/platform/linux_embedded/flutter_elinux_view.h"
 #include "flutter/shell/platform/linux_embedded/logger.h"
 #include "flutter/shell/platform/linux_embedded/system_utils.h"
@@ -21,19 +23,83 @@ namespace flutter {
 
 namespace {
 
+// Share of the process's memory limit given to the Dart old gen heap in the
+// automatic mode. The rest is left for the new gen, the engine's caches and
+// the embedder.
+constexpr double kDartOldGenHeapMemoryRatio = 0.5;
+constexpr int64_t kMinDartOldGenHeapSizeMB = 32;
+
+// Resolves the old gen heap size in MB requested by the project properties
+// into the value passed to the engine. Returns 0 for the VM's default.
+int64_t ResolveDartOldGenHeapSize(int64_t requested) {
+  if (requested != kFlutterDesktopDartOldGenHeapSizeAuto) {
+    return requested > 0 ? requested : 0;
+  }
+
+  auto limit_mb = static_cast<int64_t>(GetProcessMemoryLimit() >> 20);
+  auto size = std::max(
+      static_cast<int64_t>(limit_mb * kDartOldGenHeapMemoryRatio),
+      kMinDartOldGenHeapSizeMB);
+  ELINUX_LOG(INFO) << "Memory limit: " << limit_mb
+                   << " MB, Dart old gen heap size: " << size << " MB";
+  return size;
+}
+
 // Creates and returns a FlutterRendererConfig that renders to the view (if any)
 // of a FlutterELinuxEngine, which should be the user_data received by the
 // render callbacks.
-FlutterRendererConfig GetRendererConfig() {
+#if defined(USE_VULKAN)
+FlutterRendererConfig GetRendererConfig(ELinuxRenderSurfaceTarget* surface) {
+  FlutterRendererConfig config = {};
+  config.type = kVulkan;
+  config.vulkan.struct_size = sizeof(config.vulkan);
+  surface->GetRendererConfig(&config.vulkan);
+  config.vulkan.get_instance_proc_address_callback =
+      [](void* user_data, FlutterVulkanInstanceHandle instance,
+         const char* name) -> void* {
+    auto host = static_cast<FlutterELinuxEngine*>(user_data);
+    if (!host->view()) {
+      return nullptr;
+    }
+    return host->view()->GetInstanceProcAddress(instance, name);
+  };
+  config.vulkan.get_next_image_callback =
+      [](void* user_data,
+         const FlutterFrameInfo* frame_info) -> FlutterVulkanImage {
+    auto host = static_cast<FlutterELinuxEngine*>(user_data);
+    if (!host->view()) {
+      FlutterVulkanImage image = {};
+      image.struct_size = sizeof(FlutterVulkanImage);
+      return image;
+    }
+    return host->view()->GetNextImage(frame_info);
+  };
+  config.vulkan.present_image_callback =
+      [](void* user_data, const FlutterVulkanImage* image) -> bool {
+    auto host = static_cast<FlutterELinuxEngine*>(user_data);
+    if (!host->view()) {
+      return false;
+    }
+    return host->view()->PresentImage(image);
+  };
+  return config;
+}
+#else
+// |fbo_reset_after_present| must be set if the window renders each frame into
+// a different framebuffer object.
+FlutterRendererConfig GetRendererConfig(bool fbo_reset_after_present) {
   FlutterRendererConfig config = {};
   config.type = kOpenGL;
   config.open_gl.struct_size = sizeof(config.open_gl);
   config.open_gl.make_current = [](void* user_data) -> bool {
     auto host = static_cast<FlutterELinuxEngine*>(user_data);
-    if (!host->view()) {
+    if (!host->view() || !host->view()->MakeCurrent()) {
       return false;
     }
-    return host->view()->MakeCurrent();
+    // The formats are a property of the engine's context, which is first
+    // made current here.
+    host->texture_registrar()->QueryCompressedFormats();
+    return true;
   };
   config.open_gl.clear_current = [](void* user_data) -> bool {
     auto host = static_cast<FlutterELinuxEngine*>(user_data);
@@ -56,6 +122,7 @@ FlutterRendererConfig GetRendererConfig() {
     }
     return host->view()->GetOnscreenFBO();
   };
+  config.open_gl.fbo_reset_after_present = fbo_reset_after_present;
   config.open_gl.gl_proc_resolver = [](void* user_data,
                                        const char* name) -> void* {
     auto host = static_cast<FlutterELinuxEngine*>(user_data);
@@ -88,6 +155,7 @@ FlutterRendererConfig GetRendererConfig() {
   };
   return config;
 }
+#endif
 
 // Converts a FlutterPlatformMessage to an equivalent FlutterDesktopMessage.
 static FlutterDesktopMessage ConvertToDesktopMessage(
@@ -135,6 +203,13 @@ FlutterELinuxEngine::FlutterELinuxEngine(const FlutterProjectBundle& project)
   FlutterELinuxTextureRegistrar::ResolveGlFunctions(gl_procs_);
   texture_registrar_ =
       std::make_unique<FlutterELinuxTextureRegistrar>(this, gl_procs_);
+  if (project_->texture_memory_budget() > 0) {
+    texture_registrar_->SetMemoryBudget(
+        static_cast<uint64_t>(project_->texture_memory_budget()) * 1024 * 1024);
+  }
+  if (project_->downscale_external_textures()) {
+    texture_registrar_->EnableDownscaling();
+  }
 
   // Set up internal channels.
   // TODO: Replace this with an embedder.h API. See
@@ -227,6 +302,9 @@ bool FlutterELinuxEngine::RunWithEntrypoint(const char* entrypoint) {
   args.vsync_callback = [](void* user_data, intptr_t baton) -> void {
     auto host = static_cast<FlutterELinuxEngine*>(user_data);
     host->vsync_waiter_->NotifyWaitForVsync(baton);
+    // The vsync is delivered from the view's event dispatch, so let hosts
+    // which wait on the poll fds know that it has to run.
+    host->task_runner_->WakeUp();
   };
 #endif
 #endif
@@ -239,6 +317,11 @@ bool FlutterELinuxEngine::RunWithEntrypoint(const char* entrypoint) {
     args.custom_dart_entrypoint = entrypoint;
   }
 
+  dart_old_gen_heap_size_ =
+      ResolveDartOldGenHeapSize(project_->dart_old_gen_heap_size());
+  args.dart_old_gen_heap_size =
+      dart_old_gen_heap_size_ > 0 ? dart_old_gen_heap_size_ : -1;
+
   args.log_message_callback = [](const char* tag, const char* message,
                                  void* user_data) {
     std::string str_tag(tag);
@@ -248,7 +331,18 @@ bool FlutterELinuxEngine::RunWithEntrypoint(const char* entrypoint) {
     std::cout << message << std::endl;
   };
 
-  auto renderer_config = GetRendererConfig();
+#if defined(USE_VULKAN)
+  if (!view_ || !view_->GetRenderSurfaceTarget()) {
+    ELINUX_LOG(ERROR) << "The Vulkan renderer requires a render surface.";
+    return false;
+  }
+  auto renderer_config = GetRendererConfig(view_->GetRenderSurfaceTarget());
+#else
+  // The window of an engine started without a view isn't known yet, so it
+  // may be one which renders to framebuffer objects.
+  auto renderer_config =
+      GetRendererConfig(!view_ || view_->RendersToFramebuffer());
+#endif
   auto result = embedder_api_.Run(FLUTTER_ENGINE_VERSION, &renderer_config,
                                   &args, this, &engine_);
   if (result != kSuccess || engine_ == nullptr) {
@@ -257,6 +351,7 @@ bool FlutterELinuxEngine::RunWithEntrypoint(const char* entrypoint) {
   }
 
   SendSystemSettings();
+  SendDisplayInfo();
 
   return true;
 }
@@ -268,11 +363,26 @@ bool FlutterELinuxEngine::Stop() {
     }
     FlutterEngineResult result = embedder_api_.Shutdown(engine_);
     engine_ = nullptr;
+    CancelPendingReplies();
     return (result == kSuccess);
   }
+  // Messages may be queued before the engine runs, or after it stopped.
+  CancelPendingReplies();
   return false;
 }
 
+void FlutterELinuxEngine::CancelPendingReplies() {
+  std::map<uint64_t, PendingReply> pending_replies;
+  {
+    std::lock_guard<std::mutex> lock(pending_replies_mutex_);
+    pending_replies.swap(pending_replies_);
+  }
+  // Called without the lock, since a reply may send another message.
+  for (const auto& [id, pending] : pending_replies) {
+    pending.reply(nullptr, 0, pending.user_data);
+  }
+}
+
 void FlutterELinuxEngine::SetView(FlutterELinuxView* view) {
   view_ = view;
 }
@@ -306,6 +416,53 @@ bool FlutterELinuxEngine::SendPlatformMessage(
     const size_t message_size,
     const FlutterDesktopBinaryReply reply,
     void* user_data) {
+  if (task_runner_->RunsTasksOnCurrentThread()) {
+    return SendPlatformMessageOnPlatformThread(channel, message, message_size,
+                                               reply, user_data);
+  }
+
+  // The caller may free |message| as soon as this returns, so it's copied
+  // once here and then moved along with the task.
+  std::string channel_name(channel);
+  std::vector<uint8_t> payload(message, message + message_size);
+  // The reply is kept by the engine rather than by the task, so that Stop()
+  // can call it if the task never runs.
+  std::optional<uint64_t> reply_id;
+  if (reply != nullptr && user_data != nullptr) {
+    std::lock_guard<std::mutex> lock(pending_replies_mutex_);
+    reply_id = next_pending_reply_id_++;
+    pending_replies_[*reply_id] = {reply, user_data};
+  }
+  task_runner_->PostTask([this, channel_name = std::move(channel_name),
+                          payload = std::move(payload), reply_id]() {
+    PendingReply pending = {};
+    if (reply_id) {
+      std::lock_guard<std::mutex> lock(pending_replies_mutex_);
+      auto it = pending_replies_.find(*reply_id);
+      if (it == pending_replies_.end()) {
+        // Already called with no data by Stop().
+        return;
+      }
+      pending = it->second;
+      pending_replies_.erase(it);
+    }
+    if (!SendPlatformMessageOnPlatformThread(channel_name.c_str(),
+                                             payload.data(), payload.size(),
+                                             pending.reply,
+                                             pending.user_data) &&
+        pending.reply != nullptr) {
+      pending.reply(nullptr, 0, pending.user_data);
+    }
+  });
+  return true;
+}
+
+bool FlutterELinuxEngine::SendPlatformMessageOnPlatformThread(
+    const char* channel,
+    const uint8_t* message,
+    const size_t message_size,
+    const FlutterDesktopBinaryReply reply,
+    void* user_data) {
   FlutterPlatformMessageResponseHandle* response_handle = nullptr;
   if (reply != nullptr && user_data != nullptr) {
     FlutterEngineResult result =
@@ -350,6 +507,8 @@ void FlutterELinuxEngine::HandlePlatformMessage(
     return;
   }
 
+  ScopedAllocationRegion allocation_region(
+      kFlutterDesktopAllocationRegionMessageDispatcher);
   auto message = ConvertToDesktopMessage(*engine_message);
 
   message_dispatcher_->HandleMessage(
@@ -402,8 +561,31 @@ bool FlutterELinuxEngine::MarkExternalTextureFrameAvailable(
               engine_, texture_id) == kSuccess);
 }
 
+bool FlutterELinuxEngine::PostRasterThreadTask(std::function<void()> task) {
+  if (!engine_) {
+    return false;
+  }
+  auto* baton = new std::function<void()>(std::move(task));
+  auto result = embedder_api_.PostRenderThreadTask(
+      engine_,
+      [](void* user_data) {
+        auto* task = static_cast<std::function<void()>*>(user_data);
+        (*task)();
+        delete task;
+      },
+      baton);
+  if (result != kSuccess) {
+    ELINUX_LOG(ERROR) << "Failed to post a raster thread task.";
+    delete baton;
+    return false;
+  }
+  return true;
+}
+
 void FlutterELinuxEngine::OnVsync(uint64_t last_frame_time_nanos,
                                   uint64_t vsync_interval_time_nanos) {
+  ScopedAllocationRegion allocation_region(
+      kFlutterDesktopAllocationRegionVsync);
   uint64_t current_time_nanos = embedder_api_.GetCurrentTime();
   uint64_t after_vsync_passed_time_nanos =
       (current_time_nanos - last_frame_time_nanos) % vsync_interval_time_nanos;
@@ -417,4 +599,39 @@ void FlutterELinuxEngine::OnVsync(uint64_t last_frame_time_nanos,
                              frame_target_time_nanos);
 }
 
+void FlutterELinuxEngine::SendDisplayInfo() {
+  if (!view_ || !engine_) {
+    return;
+  }
+  FlutterEngineDisplay display = {};
+  display.struct_size = sizeof(FlutterEngineDisplay);
+  display.single_display = true;
+  display.refresh_rate = view_->GetFrameRate() / 1000.0;
+  // The embedder API has no other update type, and the engine replaces the
+  // displays it knows with each update.
+  if (embedder_api_.NotifyDisplayUpdate(
+          engine_, kFlutterEngineDisplaysUpdateTypeStartup, &display, 1) !=
+      kSuccess) {
+    ELINUX_LOG(WARNING) << "Failed to notify the display refresh rate";
+  }
+}
+
+void FlutterELinuxEngine::GetStats(FlutterDesktopEngineStats* stats) {
+  AllocationTracker::GetStats(stats);
+  stats->dart_old_gen_heap_size = dart_old_gen_heap_size_;
+  texture_registrar_->GetStats(stats);
+}
+
+std::vector<int> FlutterELinuxEngine::GetPollFds() const {
+  std::vector<int> fds;
+  if (task_runner_ && task_runner_->GetWakeupFd() != -1) {
+    fds.push_back(task_runner_->GetWakeupFd());
+  }
+  if (view_) {
+    auto view_fds = view_->GetPollFds();
+    fds.insert(fds.end(), view_fds.begin(), view_fds.end());
+  }
+  return fds;
+}
+
 }  // namespace flutter
@@ -7,8 +7,10 @@
 
 #include <rapidjson/document.h>
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <vector>
 
@@ -84,6 +86,12 @@ class FlutterELinuxEngine {
 
   // Sends the given message to the engine, calling |reply| with |user_data|
   // when a reponse is received from the engine if they are non-null.
+  //
+  // This can be called from any thread. Messages sent from other threads are
+  // copied once and sent in order from the platform thread, and true is
+  // returned once queued. If sending fails there, or the engine is stopped
+  // before the message is sent, |reply| is called with no data so that
+  // |user_data| can be released.
   bool SendPlatformMessage(const char* channel,
                            const uint8_t* message,
                            const size_t message_size,
@@ -113,10 +121,27 @@ class FlutterELinuxEngine {
   // given |texture_id|.
   bool MarkExternalTextureFrameAvailable(int64_t texture_id);
 
+  // Posts |task| to the raster thread. The task runs after the raster tasks
+  // already scheduled by the engine.
+  //
+  // Returns false if the engine isn't running or the task couldn't be posted.
+  bool PostRasterThreadTask(std::function<void()> task);
+
+  // Sends the refresh rate of the view's display to the engine, which paces
+  // the frames with it. Called again when the display changes.
+  void SendDisplayInfo();
+
   // Notifies the engine about the vsync event.
   void OnVsync(uint64_t last_frame_time_nanos,
                uint64_t vsync_interval_time_nanos);
 
+  // Fills |stats| with the runtime statistics of this engine.
+  void GetStats(FlutterDesktopEngineStats* stats);
+
+  // Returns the file descriptors which become readable when the engine or its
+  // view has work to do on the platform thread.
+  std::vector<int> GetPollFds() const;
+
  private:
   // Allows swapping out embedder_api_ calls in tests.
   friend class EngineEmbedderApiModifier;
@@ -127,6 +152,18 @@ class FlutterELinuxEngine {
   // system changes.
   void SendSystemSettings();
 
+  // Calls the replies of the messages queued from other threads with no data,
+  // and drops the messages.
+  void CancelPendingReplies();
+
+  // Sends a platform message to the engine. Must be called on the platform
+  // thread.
+  bool SendPlatformMessageOnPlatformThread(const char* channel,
+                                           const uint8_t* message,
+                                           const size_t message_size,
+                                           const FlutterDesktopBinaryReply reply,
+                                           void* user_data);
+
   // The handle to the embedder.h engine instance.
   FLUTTER_API_SYMBOL(FlutterEngine) engine_ = nullptr;
 
@@ -135,7 +172,10 @@ class FlutterELinuxEngine {
   std::unique_ptr<FlutterProjectBundle> project_;
 
   // AOT data, if any.
-  UniqueAotDataPtr aot_data_;
+  SharedAotDataPtr aot_data_;
+
+  // Max size of the Dart old gen heap in MB passed to the engine, or 0.
+  int64_t dart_old_gen_heap_size_ = 0;
 
   // The view displaying the content running in this engine, if any.
   FlutterELinuxView* view_ = nullptr;
@@ -171,6 +211,17 @@ class FlutterELinuxEngine {
 
   // The vsync waiter.
   std::unique_ptr<VsyncWaiter> vsync_waiter_;
+
+  // The replies of the messages sent from other threads which are queued to
+  // the platform thread, by ID. Stop() calls them with no data and clears
+  // this, so that the queued messages are dropped.
+  struct PendingReply {
+    FlutterDesktopBinaryReply reply;
+    void* user_data;
+  };
+  std::mutex pending_replies_mutex_;
+  std::map<uint64_t, PendingReply> pending_replies_;
+  uint64_t next_pending_reply_id_ = 0;
 };
 
 }  // namespace flutter
@@ -4,16 +4,36 @@
 
 #include "flutter/shell/platform/linux_embedded/flutter_elinux_texture_registrar.h"
 
+#include <cstring>
 #include <iostream>
 #include <mutex>
+#include <vector>
 
 #include "flutter/shell/platform/embedder/embedder_struct_macros.h"
+#include "flutter/shell/platform/linux_embedded/external_texture_compressed.h"
+#include "flutter/shell/platform/linux_embedded/external_texture_gl.h"
 #include "flutter/shell/platform/linux_embedded/external_texture_pixelbuffer.h"
 #include "flutter/shell/platform/linux_embedded/flutter_elinux_engine.h"
 #include "flutter/shell/platform/linux_embedded/flutter_elinux_view.h"
+#include "flutter/shell/platform/linux_embedded/logger.h"
+#include "flutter/shell/platform/linux_embedded/surface/context_egl_shared.h"
 
 namespace {
 static constexpr int64_t kInvalidTexture = -1;
+
+// Compressed formats which are uploaded as is for compressed pixel buffers if
+// GL supports them.
+constexpr uint32_t kSampleableCompressedFormats[] = {
+    0x8D64,  // GL_ETC1_RGB8_OES
+    0x9274,  // GL_COMPRESSED_RGB8_ETC2
+    0x83F0,  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    0x83F1,  // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+};
+
+// GL_COMPRESSED_RGBA_ASTC_4x4_KHR to GL_COMPRESSED_RGBA_ASTC_12x12_KHR of
+// KHR_texture_compression_astc_ldr.
+constexpr uint32_t kAstcFirstFormat = 0x93B0;
+constexpr uint32_t kAstcLastFormat = 0x93BD;
 }
 
 namespace flutter {
@@ -21,38 +41,100 @@ namespace flutter {
 FlutterELinuxTextureRegistrar::FlutterELinuxTextureRegistrar(
     FlutterELinuxEngine* engine,
     const GlProcs& gl_procs)
-    : engine_(engine), gl_procs_(gl_procs) {}
+    : engine_(engine), gl_procs_(gl_procs), texture_pool_(gl_procs) {}
+
+void FlutterELinuxTextureRegistrar::SetMemoryBudget(uint64_t bytes) {
+  std::lock_guard<std::mutex> lock(map_mutex_);
+  memory_budget_ = bytes;
+}
+
+void FlutterELinuxTextureRegistrar::EnableDownscaling() {
+  std::lock_guard<std::mutex> lock(map_mutex_);
+  downscaling_enabled_ = true;
+}
 
 int64_t FlutterELinuxTextureRegistrar::RegisterTexture(
     const FlutterDesktopTextureInfo* texture_info) {
+#if defined(USE_VULKAN)
+  // The engine only populates external textures with the GL renderer.
+  std::cerr << "External textures aren't supported with Vulkan." << std::endl;
+  return kInvalidTexture;
+#else
   if (!gl_procs_.valid) {
     return kInvalidTexture;
   }
 
+  {
+    // Evictable storage is freed whenever a texture is displayed, so what
+    // remains over the budget can't be reclaimed.
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    if (memory_budget_ > 0 &&
+        pixel_buffer_bytes_ + gpu_surface_bytes_ > memory_budget_) {
+      std::cerr << "The textures exceed the memory budget of "
+                << memory_budget_ << " bytes." << std::endl;
+      return kInvalidTexture;
+    }
+  }
+
   if (texture_info->type == kFlutterDesktopPixelBufferTexture) {
     if (!texture_info->pixel_buffer_config.callback) {
       std::cerr << "Invalid pixel buffer texture callback." << std::endl;
       return kInvalidTexture;
     }
 
-    return EmplaceTexture(std::make_unique<flutter::ExternalTexturePixelBuffer>(
+    TextureDownscaler* downscaler;
+    {
+      std::lock_guard<std::mutex> lock(map_mutex_);
+      downscaler = downscaling_enabled_ ? &downscaler_ : nullptr;
+    }
+    auto texture = std::make_unique<flutter::ExternalTexturePixelBuffer>(
         texture_info->pixel_buffer_config.callback,
-        texture_info->pixel_buffer_config.user_data, gl_procs_));
+        texture_info->pixel_buffer_config.user_data, gl_procs_,
+        &texture_pool_, downscaler);
+    return EmplaceTexture(std::move(texture), texture_info->type,
+                          /*evictable=*/true);
   } else if (texture_info->type == kFlutterDesktopGpuSurfaceTexture) {
-    std::cerr << "GpuSurfaceTexture is not yet supported." << std::endl;
-    return kInvalidTexture;
+    const auto& config = texture_info->gpu_surface_config;
+    if (config.type != kFlutterDesktopGpuSurfaceTypeGlTexture &&
+        config.type != kFlutterDesktopGpuSurfaceTypeCompressedPixelBuffer) {
+      std::cerr << "Only GL texture and compressed pixel buffer GPU surfaces "
+                   "are supported."
+                << std::endl;
+      return kInvalidTexture;
+    }
+    if (!config.callback) {
+      std::cerr << "Invalid GPU surface texture callback." << std::endl;
+      return kInvalidTexture;
+    }
+
+    if (config.type == kFlutterDesktopGpuSurfaceTypeCompressedPixelBuffer) {
+      auto texture = std::make_unique<flutter::ExternalTextureCompressed>(
+          config.callback, config.user_data, gl_procs_, this);
+      return EmplaceTexture(std::move(texture), texture_info->type,
+                            /*evictable=*/true);
+    }
+    auto texture = std::make_unique<flutter::ExternalTextureGl>(
+        config.callback, config.user_data);
+    return EmplaceTexture(std::move(texture), texture_info->type,
+                          /*evictable=*/false);
   }
 
   std::cerr << "Attempted to register texture of unsupport type." << std::endl;
   return kInvalidTexture;
+#endif
 }
 
 int64_t FlutterELinuxTextureRegistrar::EmplaceTexture(
-    std::unique_ptr<ExternalTexture> texture) {
+    std::unique_ptr<ExternalTexture> texture,
+    FlutterDesktopTextureType type,
+    bool evictable) {
   int64_t texture_id = texture->texture_id();
   {
     std::lock_guard<std::mutex> lock(map_mutex_);
-    textures_[texture_id] = std::move(texture);
+    auto& entry = textures_[texture_id];
+    entry.texture = std::move(texture);
+    entry.type = type;
+    entry.evictable = evictable;
   }
 
   engine_->task_runner()->RunNowOrPostTask([engine = engine_, texture_id]() {
@@ -65,15 +147,34 @@ int64_t FlutterELinuxTextureRegistrar::EmplaceTexture(
 bool FlutterELinuxTextureRegistrar::UnregisterTexture(int64_t texture_id) {
   {
     std::lock_guard<std::mutex> lock(map_mutex_);
-    auto it = textures_.find(texture_id);
-    if (it == textures_.end()) {
+    if (textures_.find(texture_id) == textures_.end()) {
       return false;
     }
-    textures_.erase(it);
   }
 
-  engine_->task_runner()->RunNowOrPostTask([engine = engine_, texture_id]() {
-    engine->UnregisterExternalTexture(texture_id);
+  engine_->task_runner()->RunNowOrPostTask([this, texture_id]() {
+    engine_->UnregisterExternalTexture(texture_id);
+
+    // The engine unregisters the texture on the raster thread, so this task
+    // runs after the last frame which used it.
+    auto destroy_texture = [this, texture_id]() {
+      std::unique_ptr<ExternalTexture> texture;
+      {
+        std::lock_guard<std::mutex> lock(map_mutex_);
+        auto it = textures_.find(texture_id);
+        if (it == textures_.end()) {
+          return;
+        }
+        UpdateStorageBytes(it->second, 0);
+        texture = std::move(it->second.texture);
+        textures_.erase(it);
+      }
+      RunWithGlContext([&texture]() { texture.reset(); });
+    };
+    if (!engine_->PostRasterThreadTask(destroy_texture)) {
+      // The engine isn't running: nothing can use the texture anymore.
+      destroy_texture();
+    }
   });
   return true;
 }
@@ -86,6 +187,14 @@ bool FlutterELinuxTextureRegistrar::MarkTextureFrameAvailable(
   return true;
 }
 
+bool FlutterELinuxTextureRegistrar::PostRasterThreadTask(
+    void (*callback)(void* user_data),
+    void* user_data) {
+  return engine_->PostRasterThreadTask([this, callback, user_data]() {
+    RunWithGlContext([callback, user_data]() { callback(user_data); });
+  });
+}
+
 bool FlutterELinuxTextureRegistrar::PopulateTexture(
     int64_t texture_id,
     size_t width,
@@ -98,9 +207,172 @@ bool FlutterELinuxTextureRegistrar::PopulateTexture(
     if (it == textures_.end()) {
       return false;
     }
-    texture = it->second.get();
+    texture = it->second.texture.get();
+    it->second.last_displayed = ++display_sequence_;
+    it->second.last_displayed_frame = frame_number_;
+  }
+  // While the engine runs, textures are only destroyed on this thread. They
+  // are destroyed on the platform thread once it has stopped, which is when
+  // it doesn't populate textures anymore. So |texture| stays valid.
+  auto result = texture->PopulateTexture(width, height, opengl_texture);
+
+  std::lock_guard<std::mutex> lock(map_mutex_);
+  auto it = textures_.find(texture_id);
+  if (it != textures_.end()) {
+    UpdateStorageBytes(it->second, texture->GetStorageBytes());
+    EnforceMemoryBudget();
+  }
+  return result;
+}
+
+void FlutterELinuxTextureRegistrar::UpdateStorageBytes(TextureEntry& entry,
+                                                       size_t bytes) {
+  auto& total = entry.evictable ? pixel_buffer_bytes_ : gpu_surface_bytes_;
+  total = total - entry.bytes + bytes;
+  entry.bytes = bytes;
+}
+
+void FlutterELinuxTextureRegistrar::OnFramePresented() {
+  std::lock_guard<std::mutex> lock(map_mutex_);
+  frame_number_++;
+}
+
+void FlutterELinuxTextureRegistrar::EnforceMemoryBudget() {
+  while (memory_budget_ > 0 &&
+         pixel_buffer_bytes_ + gpu_surface_bytes_ > memory_budget_) {
+    // Only textures uploaded by the embedder can be evicted: they are
+    // uploaded again from their callback. GL textures are owned by the
+    // plugins.
+    TextureEntry* oldest = nullptr;
+    int64_t oldest_id = 0;
+    for (auto& [id, entry] : textures_) {
+      if (entry.last_displayed_frame == frame_number_ || entry.bytes == 0 ||
+          !entry.evictable) {
+        continue;
+      }
+      if (!oldest || entry.last_displayed < oldest->last_displayed) {
+        oldest = &entry;
+        oldest_id = id;
+      }
+    }
+    if (!oldest) {
+      std::cerr << "The textures exceed the memory budget of "
+                << memory_budget_ << " bytes, but none can be evicted."
+                << std::endl;
+      return;
+    }
+
+    oldest->texture->EvictStorage();
+    UpdateStorageBytes(*oldest, oldest->texture->GetStorageBytes());
+    eviction_count_++;
+    ELINUX_LOG(TRACE) << "Evicted the storage of texture " << oldest_id
+                      << " to stay within the texture memory budget.";
+  }
+}
+
+bool FlutterELinuxTextureRegistrar::IsCompressedFormatSupported(
+    uint32_t format) {
+  if (!compressed_formats_queried_) {
+    return false;
+  }
+  return compressed_formats_.find(format) != compressed_formats_.end();
+}
+
+void FlutterELinuxTextureRegistrar::QueryCompressedFormats() {
+  if (compressed_formats_queried_ || !gl_procs_.valid) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(compressed_formats_mutex_);
+  if (compressed_formats_queried_) {
+    return;
+  }
+
+  GLint count = 0;
+  gl_procs_.glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+  std::vector<GLint> formats(count);
+  if (count > 0) {
+    gl_procs_.glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+  }
+  for (auto format : formats) {
+    for (auto sampleable : kSampleableCompressedFormats) {
+      if (static_cast<uint32_t>(format) == sampleable) {
+        compressed_formats_.insert(sampleable);
+      }
+    }
+    if (static_cast<uint32_t>(format) >= kAstcFirstFormat &&
+        static_cast<uint32_t>(format) <= kAstcLastFormat) {
+      compressed_formats_.insert(format);
+    }
+  }
+
+  // Some drivers don't list the ASTC formats of the extension.
+  auto extensions = reinterpret_cast<const char*>(
+      gl_procs_.glGetString(GL_EXTENSIONS));
+  if (extensions &&
+      strstr(extensions, "GL_KHR_texture_compression_astc_ldr")) {
+    for (auto format = kAstcFirstFormat; format <= kAstcLastFormat;
+         format++) {
+      compressed_formats_.insert(format);
+    }
+  }
+
+  compressed_formats_queried_ = true;
+}
+
+void FlutterELinuxTextureRegistrar::RunWithGlContext(
+    const std::function<void()>& task) {
+#if defined(USE_VULKAN)
+  task();
+#else
+  // The context of the caller, if any, is restored afterwards.
+  EGLDisplay display = eglGetCurrentDisplay();
+  EGLContext context = eglGetCurrentContext();
+  EGLSurface draw_surface = eglGetCurrentSurface(EGL_DRAW);
+  EGLSurface read_surface = eglGetCurrentSurface(EGL_READ);
+
+  ContextEglShared* task_context;
+  {
+    // Tasks can be posted from several threads, so only one creates the
+    // context. It's then only made current by one thread at a time: the
+    // raster thread, or the platform thread once the engine has stopped.
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    if (!task_context_ && engine_->view()) {
+      task_context_ = CreateSharedGlContext();
+    }
+    task_context = task_context_.get();
+  }
+  bool made_current =
+      task_context && task_context->IsValid() && task_context->MakeCurrent();
+  task();
+  if (!made_current) {
+    return;
+  }
+  if (context != EGL_NO_CONTEXT) {
+    eglMakeCurrent(display, draw_surface, read_surface, context);
+  } else {
+    task_context->ClearCurrent();
   }
-  return texture->PopulateTexture(width, height, opengl_texture);
+#endif
+}
+
+std::unique_ptr<ContextEglShared>
+FlutterELinuxTextureRegistrar::CreateSharedGlContext() {
+  if (!engine_->view()) {
+    std::cerr << "Shared GL contexts require a view." << std::endl;
+    return nullptr;
+  }
+  return engine_->view()->CreateSharedGlContext();
+}
+
+void FlutterELinuxTextureRegistrar::GetStats(FlutterDesktopEngineStats* stats) {
+  texture_pool_.GetStats(stats);
+
+  std::lock_guard<std::mutex> lock(map_mutex_);
+  stats->texture_count = textures_.size();
+  stats->pixel_buffer_texture_bytes = pixel_buffer_bytes_;
+  stats->gpu_surface_texture_bytes = gpu_surface_bytes_;
+  stats->texture_memory_budget = memory_budget_;
+  stats->texture_evictions = eviction_count_;
 }
 
 void FlutterELinuxTextureRegistrar::ResolveGlFunctions(GlProcs& procs) {
@@ -114,10 +386,20 @@ void FlutterELinuxTextureRegistrar::ResolveGlFunctions(GlProcs& procs) {
       eglGetProcAddress("glTexParameteri"));
   procs.glTexImage2D =
       reinterpret_cast<glTexImage2DProc>(eglGetProcAddress("glTexImage2D"));
+  procs.glTexSubImage2D = reinterpret_cast<glTexSubImage2DProc>(
+      eglGetProcAddress("glTexSubImage2D"));
+  procs.glCompressedTexImage2D = reinterpret_cast<glCompressedTexImage2DProc>(
+      eglGetProcAddress("glCompressedTexImage2D"));
+  procs.glGetIntegerv =
+      reinterpret_cast<glGetIntegervProc>(eglGetProcAddress("glGetIntegerv"));
+  procs.glGetString =
+      reinterpret_cast<glGetStringProc>(eglGetProcAddress("glGetString"));
 
   procs.valid = procs.glGenTextures && procs.glDeleteTextures &&
                 procs.glBindTexture && procs.glTexParameteri &&
-                procs.glTexImage2D;
+                procs.glTexImage2D && procs.glTexSubImage2D &&
+                procs.glCompressedTexImage2D && procs.glGetIntegerv &&
+                procs.glGetString;
 }
 
 };  // namespace flutter
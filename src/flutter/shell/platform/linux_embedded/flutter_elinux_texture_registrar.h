@@ -5,15 +5,21 @@
 #ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_FLUTTER_ELINUX_TEXTURE_REGISTRAR_H_
 #define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_FLUTTER_ELINUX_TEXTURE_REGISTRAR_H_
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "flutter/shell/platform/common/public/flutter_texture_registrar.h"
 #include "flutter/shell/platform/linux_embedded/external_texture.h"
+#include "flutter/shell/platform/linux_embedded/texture_downscaler.h"
+#include "flutter/shell/platform/linux_embedded/texture_pool.h"
 
 namespace flutter {
 
+class ContextEglShared;
 class FlutterELinuxEngine;
 
 // An object managing the registration of an external texture.
@@ -23,14 +29,35 @@ class FlutterELinuxTextureRegistrar {
   explicit FlutterELinuxTextureRegistrar(FlutterELinuxEngine* engine,
                                          const GlProcs& gl_procs);
 
+  // Sets the budget of the GPU memory used by the textures in bytes. 0 means
+  // no limit.
+  void SetMemoryBudget(uint64_t bytes);
+
+  // Makes pixel buffer textures registered afterwards downscale their
+  // buffers on the GPU when they are much larger than displayed.
+  void EnableDownscaling();
+
   // Registers a texture described by the given |texture_info| object.
-  // Returns the non-zero, positive texture id or -1 on error.
+  // Returns the non-zero, positive texture id or -1 on error, including when
+  // the textures already exceed the memory budget.
   int64_t RegisterTexture(const FlutterDesktopTextureInfo* texture_info);
 
   // Attempts to unregister the texture identified by |texture_id|.
   // Returns true if the texture was successfully unregistered.
+  //
+  // The texture is destroyed on the raster thread once the engine no longer
+  // references it, or right away if the engine isn't running, with a GL
+  // context of the engine's share group current.
   bool UnregisterTexture(int64_t texture_id);
 
+  // Posts |callback| to the raster thread, where it runs with a GL context of
+  // the engine's share group current. Use this for GL work such as
+  // allocating or deleting the GL objects of a texture outside of
+  // PopulateTexture.
+  // Returns true on success.
+  bool PostRasterThreadTask(void (*callback)(void* user_data),
+                            void* user_data);
+
   // Notifies the engine about a new frame being available.
   // Returns true on success.
   bool MarkTextureFrameAvailable(int64_t texture_id);
@@ -43,6 +70,26 @@ class FlutterELinuxTextureRegistrar {
                        size_t height,
                        FlutterOpenGLTexture* texture);
 
+  // Creates a GL context for plugins which shares GL objects with the engine.
+  // Returns nullptr on error.
+  std::unique_ptr<ContextEglShared> CreateSharedGlContext();
+
+  // Returns true if GL samples compressed textures of the GL internal
+  // |format|, so that they are uploaded as is. Always false until
+  // QueryCompressedFormats has been called.
+  bool IsCompressedFormatSupported(uint32_t format);
+
+  // Queries the compressed texture formats supported by GL, if they haven't
+  // been queried yet. Must be called with the engine's context current.
+  void QueryCompressedFormats();
+
+  // Notifies that the frame being rasterized has been presented. The
+  // storage of textures drawn in a frame isn't evicted before it's presented.
+  void OnFramePresented();
+
+  // Fills the texture fields of |stats|.
+  void GetStats(FlutterDesktopEngineStats* stats);
+
   // Populates the OpenGL function pointers in |gl_procs|.
   static void ResolveGlFunctions(GlProcs& gl_procs);
 
@@ -50,12 +97,67 @@ class FlutterELinuxTextureRegistrar {
   FlutterELinuxEngine* engine_ = nullptr;
   const GlProcs& gl_procs_;
 
+  // Storage released by pixel buffer textures. Declared before |textures_|,
+  // which return their storage to it when they are destroyed.
+  TexturePool texture_pool_;
+
+  // Shared by the pixel buffer textures if |downscaling_enabled_|. Like
+  // |texture_pool_|, it must outlive |textures_|.
+  TextureDownscaler downscaler_;
+  bool downscaling_enabled_ = false;
+
+  // Made current by RunWithGlContext. Created once, on first use, under
+  // |map_mutex_|.
+  std::unique_ptr<ContextEglShared> task_context_;
+
+  struct TextureEntry {
+    std::unique_ptr<ExternalTexture> texture;
+    FlutterDesktopTextureType type;
+    // True if the embedder uploads the texture from its callback, so that its
+    // storage can be freed and uploaded again.
+    bool evictable = false;
+    // Storage size accounted for the texture.
+    size_t bytes = 0;
+    // Order in which the textures were last displayed.
+    uint64_t last_displayed = 0;
+    // The frame in which the texture was last displayed.
+    uint64_t last_displayed_frame = 0;
+  };
+
   // All registered textures, keyed by their IDs.
-  std::unordered_map<int64_t, std::unique_ptr<flutter::ExternalTexture>>
-      textures_;
+  std::unordered_map<int64_t, TextureEntry> textures_;
   std::mutex map_mutex_;
 
-  int64_t EmplaceTexture(std::unique_ptr<ExternalTexture> texture);
+  // Memory accounting, guarded by |map_mutex_|.
+  uint64_t memory_budget_ = 0;
+  uint64_t display_sequence_ = 0;
+  uint64_t frame_number_ = 1;
+  uint64_t pixel_buffer_bytes_ = 0;
+  uint64_t gpu_surface_bytes_ = 0;
+  uint64_t eviction_count_ = 0;
+
+  // Compressed texture formats reported by GL. Only read once
+  // |compressed_formats_queried_| is set.
+  std::unordered_set<uint32_t> compressed_formats_;
+  std::atomic<bool> compressed_formats_queried_ = false;
+  std::mutex compressed_formats_mutex_;
+
+  int64_t EmplaceTexture(std::unique_ptr<ExternalTexture> texture,
+                         FlutterDesktopTextureType type,
+                         bool evictable);
+
+  // Updates the accounted storage of |entry|. |map_mutex_| must be held.
+  void UpdateStorageBytes(TextureEntry& entry, size_t bytes);
+
+  // Frees the storage of the least recently displayed textures which aren't
+  // used by the current frame, until the textures fit in the budget. Must be
+  // called on the raster thread with |map_mutex_| held.
+  void EnforceMemoryBudget();
+
+  // Runs |task| with |task_context_| current, then restores the context of
+  // the calling thread. |task| still runs if no context could be made
+  // current. |map_mutex_| must not be held.
+  void RunWithGlContext(const std::function<void()>& task);
 };
 
 };  // namespace flutter
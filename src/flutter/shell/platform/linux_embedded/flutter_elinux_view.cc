@@ -7,7 +7,9 @@
 #include <chrono>
 #include <cmath>
 
+#include "flutter/shell/platform/linux_embedded/allocation_tracker.h"
 #include "flutter/shell/platform/linux_embedded/logger.h"
+#include "flutter/shell/platform/linux_embedded/surface/context_egl_shared.h"
 
 namespace flutter {
 
@@ -50,6 +52,10 @@ bool FlutterELinuxView::DispatchEvent() {
   return binding_handler_->DispatchEvent();
 }
 
+std::vector<int> FlutterELinuxView::GetPollFds() const {
+  return binding_handler_->GetPollFds();
+}
+
 void FlutterELinuxView::SetEngine(std::unique_ptr<FlutterELinuxEngine> engine) {
   engine_ = std::move(engine);
 
@@ -80,6 +86,31 @@ void FlutterELinuxView::SetEngine(std::unique_ptr<FlutterELinuxEngine> engine) {
                     binding_handler_->GetDpiScale());
 }
 
+void FlutterELinuxView::ReplaceEngine(
+    std::unique_ptr<FlutterELinuxEngine> engine) {
+  if (engine_) {
+    // Stopping calls the plugin registrar destruction callback, so that the
+    // application can release its plugins.
+    engine_->Stop();
+
+    // The internal plugins use the old engine's messenger, so they have to go
+    // before it.
+    platform_views_handler_ = nullptr;
+    navigation_handler_ = nullptr;
+    lifecycle_handler_ = nullptr;
+    cursor_handler_ = nullptr;
+    platform_handler_ = nullptr;
+    textinput_handler_ = nullptr;
+    keyboard_handler_ = nullptr;
+    internal_plugin_registrar_ = nullptr;
+    engine_ = nullptr;
+  }
+
+  if (engine) {
+    SetEngine(std::move(engine));
+  }
+}
+
 void FlutterELinuxView::RegisterPlatformViewFactory(
     const char* view_type,
     std::unique_ptr<FlutterDesktopPlatformViewFactory> factory) {
@@ -94,6 +125,10 @@ void FlutterELinuxView::OnWindowSizeChanged(size_t width, size_t height) const {
   SendWindowMetrics(width, height, binding_handler_->GetDpiScale());
 }
 
+void FlutterELinuxView::OnDisplayChanged() {
+  engine_->SendDisplayInfo();
+}
+
 void FlutterELinuxView::OnPointerMove(double x, double y) {
   auto trimmed_xy = GetPointerRotation(x, y);
   SendPointerMove(trimmed_xy.first, trimmed_xy.second);
@@ -242,6 +277,11 @@ void FlutterELinuxView::OnVirtualSpecialKey(uint32_t keycode) {
   textinput_handler_->OnKeyPressed(keycode, code_point);
 }
 
+void FlutterELinuxView::OnVirtualDeleteSurroundingText(int offset_from_cursor,
+                                                       int count) {
+  textinput_handler_->DeleteSurrounding(offset_from_cursor, count);
+}
+
 void FlutterELinuxView::OnScroll(double x,
                                  double y,
                                  double delta_x,
@@ -257,6 +297,18 @@ void FlutterELinuxView::OnVsync(uint64_t last_frame_time_nanos,
   engine_->OnVsync(last_frame_time_nanos, vsync_interval_time_nanos);
 }
 
+void FlutterELinuxView::OnDisplayPowerChanged(bool power_on) {
+  if (!lifecycle_handler_) {
+    return;
+  }
+  // Stops frame production while nothing can be seen.
+  if (power_on) {
+    lifecycle_handler_->OnResumed();
+  } else {
+    lifecycle_handler_->OnPaused();
+  }
+}
+
 FlutterELinuxView::touch_point* FlutterELinuxView::GgeTouchPoint(int32_t id) {
   const size_t nmemb = sizeof(touch_event_) / sizeof(struct touch_point);
   int invalid = -1;
@@ -398,6 +450,31 @@ void FlutterELinuxView::SendPointerEventWithData(
   }
 }
 
+#if defined(USE_VULKAN)
+void* FlutterELinuxView::GetInstanceProcAddress(
+    FlutterVulkanInstanceHandle instance,
+    const char* name) {
+  return GetRenderSurfaceTarget()->GetInstanceProcAddress(
+      static_cast<VkInstance>(instance), name);
+}
+
+FlutterVulkanImage FlutterELinuxView::GetNextImage(
+    const FlutterFrameInfo* frame_info) {
+  return GetRenderSurfaceTarget()->AcquireNextImage(frame_info->size.width,
+                                                    frame_info->size.height);
+}
+
+bool FlutterELinuxView::PresentImage(const FlutterVulkanImage* image) {
+  bool result;
+  {
+    ScopedAllocationRegion allocation_region(
+        kFlutterDesktopAllocationRegionPresent);
+    result = GetRenderSurfaceTarget()->Present(image);
+  }
+  AllocationTracker::OnFramePresented();
+  return result;
+}
+#else
 void* FlutterELinuxView::ProcResolver(const char* name) {
   return GetRenderSurfaceTarget()->GlProcResolver(name);
 }
@@ -411,7 +488,15 @@ bool FlutterELinuxView::ClearCurrent() {
 }
 
 bool FlutterELinuxView::Present() {
-  return GetRenderSurfaceTarget()->GLContextPresent(0);
+  bool result;
+  {
+    ScopedAllocationRegion allocation_region(
+        kFlutterDesktopAllocationRegionPresent);
+    result = GetRenderSurfaceTarget()->GLContextPresent(0);
+  }
+  AllocationTracker::OnFramePresented();
+  engine_->texture_registrar()->OnFramePresented();
+  return result;
 }
 
 uint32_t FlutterELinuxView::GetOnscreenFBO() {
@@ -422,6 +507,24 @@ bool FlutterELinuxView::MakeResourceCurrent() {
   return GetRenderSurfaceTarget()->ResourceContextMakeCurrent();
 }
 
+bool FlutterELinuxView::RendersToFramebuffer() {
+  return GetRenderSurfaceTarget() &&
+         GetRenderSurfaceTarget()->RendersToFramebuffer();
+}
+#endif
+
+std::unique_ptr<ContextEglShared> FlutterELinuxView::CreateSharedGlContext() {
+#if defined(USE_VULKAN)
+  return nullptr;
+#else
+  auto* surface = GetRenderSurfaceTarget();
+  if (!surface) {
+    return nullptr;
+  }
+  return surface->CreateSharedContext();
+#endif
+}
+
 bool FlutterELinuxView::CreateRenderSurface() {
   PhysicalWindowBounds bounds = binding_handler_->GetPhysicalWindowBounds();
   return binding_handler_->CreateRenderSurface(bounds.width, bounds.height);
@@ -444,7 +547,10 @@ int32_t FlutterELinuxView::GetFrameRate() {
 }
 
 FlutterTransformation FlutterELinuxView::GetRootSurfaceTransformation() {
-  auto degree = binding_handler_->GetRotationDegree();
+  // The frames are rendered unrotated if the display rotates them.
+  auto degree = binding_handler_->IsRotationAppliedByDisplay()
+                    ? 0
+                    : binding_handler_->GetRotationDegree();
   if (view_rotation_degree_ != degree) {
     view_rotation_transformation_ = FlutterTransformationMake(degree);
   }
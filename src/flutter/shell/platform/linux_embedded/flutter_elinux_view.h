@@ -27,6 +27,8 @@
 
 namespace flutter {
 
+class ContextEglShared;
+
 class FlutterELinuxView : public WindowBindingHandlerDelegate {
  public:
   // Creates a FlutterELinuxView with the given implementator of
@@ -42,10 +44,20 @@ class FlutterELinuxView : public WindowBindingHandlerDelegate {
   // you have to call this every time in the main loop.
   bool DispatchEvent();
 
+  // Returns the file descriptors which become readable when DispatchEvent()
+  // has events to handle.
+  std::vector<int> GetPollFds() const;
+
   // Configures the window instance with an instance of a running Flutter
   // engine.
   void SetEngine(std::unique_ptr<FlutterELinuxEngine> engine);
 
+  // Shuts down and destroys the current engine, then configures the window
+  // with |engine|. The render surface is kept, so the last frame stays on
+  // screen until |engine| presents its first one. If |engine| is null, the
+  // view is left without an engine and may then only be destroyed.
+  void ReplaceEngine(std::unique_ptr<FlutterELinuxEngine> engine);
+
   // Registers a factory of the platform view.
   void RegisterPlatformViewFactory(
       const char* view_type,
@@ -70,6 +82,13 @@ class FlutterELinuxView : public WindowBindingHandlerDelegate {
   // Returns the frame rate of the display.
   int32_t GetFrameRate();
 
+#if defined(USE_VULKAN)
+  // Callbacks for acquiring and presenting swapchain images.
+  void* GetInstanceProcAddress(FlutterVulkanInstanceHandle instance,
+                               const char* name);
+  FlutterVulkanImage GetNextImage(const FlutterFrameInfo* frame_info);
+  bool PresentImage(const FlutterVulkanImage* image);
+#else
   // Callbacks for clearing context, settings context and swapping buffers.
   void* ProcResolver(const char* name);
   bool MakeCurrent();
@@ -78,12 +97,25 @@ class FlutterELinuxView : public WindowBindingHandlerDelegate {
   uint32_t GetOnscreenFBO();
   bool MakeResourceCurrent();
 
+  // Returns true if the window renders into framebuffer objects which may
+  // change between frames.
+  bool RendersToFramebuffer();
+#endif
+
+  // Creates a context for plugins which shares GL objects with the engine.
+  // Returns nullptr if the render surface doesn't support it, such as with the
+  // Vulkan renderer.
+  std::unique_ptr<ContextEglShared> CreateSharedGlContext();
+
   // Send initial bounds to embedder.  Must occur after engine has initialized.
   void SendInitialBounds();
 
   // |WindowBindingHandlerDelegate|
   void OnWindowSizeChanged(size_t width, size_t height) const override;
 
+  // |WindowBindingHandlerDelegate|
+  void OnDisplayChanged() override;
+
   // |WindowBindingHandlerDelegate|
   void OnPointerMove(double x, double y) override;
 
@@ -130,6 +162,10 @@ class FlutterELinuxView : public WindowBindingHandlerDelegate {
   // |WindowBindingHandlerDelegate|
   void OnVirtualSpecialKey(uint32_t keycode) override;
 
+  // |WindowBindingHandlerDelegate|
+  void OnVirtualDeleteSurroundingText(int offset_from_cursor,
+                                      int count) override;
+
   // |WindowBindingHandlerDelegate|
   void OnScroll(double x,
                 double y,
@@ -141,6 +177,9 @@ class FlutterELinuxView : public WindowBindingHandlerDelegate {
   void OnVsync(uint64_t frame_start_time_nanos,
                uint64_t frame_target_time_nanos) override;
 
+  // |WindowBindingHandlerDelegate|
+  void OnDisplayPowerChanged(bool power_on) override;
+
  private:
   // Struct holding the mouse state. The engine doesn't keep track of which
   // mouse buttons have been pressed, so it's the embedding's responsibility.
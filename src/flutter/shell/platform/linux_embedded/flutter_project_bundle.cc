@@ -7,7 +7,9 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "flutter/shell/platform/common/engine_switches.h"
 #include "flutter/shell/platform/linux_embedded/logger.h"
@@ -34,6 +36,10 @@ FlutterProjectBundle::FlutterProjectBundle(
     aot_library_path_ = "";
   }
 
+  dart_old_gen_heap_size_ = properties.dart_old_gen_heap_size;
+  texture_memory_budget_ = properties.texture_memory_budget;
+  downscale_external_textures_ = properties.downscale_external_textures;
+
   for (int i = 0; i < properties.dart_entrypoint_argc; i++) {
     dart_entrypoint_arguments_.push_back(
         std::string(properties.dart_entrypoint_argv[i]));
@@ -65,7 +71,7 @@ bool FlutterProjectBundle::HasValidPaths() {
 
 // Attempts to load AOT data from the given path, which must be absolute and
 // non-empty. Logs and returns nullptr on failure.
-UniqueAotDataPtr FlutterProjectBundle::LoadAotData(
+SharedAotDataPtr FlutterProjectBundle::LoadAotData(
     const FlutterEngineProcTable& engine_procs) {
   if (aot_library_path_.empty()) {
     ELINUX_LOG(ERROR)
@@ -73,6 +79,25 @@ UniqueAotDataPtr FlutterProjectBundle::LoadAotData(
     return nullptr;
   }
 
+  // The loaded data of each AOT library, as long as any engine uses it.
+  static std::mutex loaded_aot_data_mutex;
+  static std::unordered_map<std::string, std::weak_ptr<_FlutterEngineAOTData>>
+      loaded_aot_data;
+  std::lock_guard<std::mutex> lock(loaded_aot_data_mutex);
+  // Drop the entries of libraries which no engine uses any more, so that
+  // apps loading many libraries over time don't grow the map.
+  for (auto it = loaded_aot_data.begin(); it != loaded_aot_data.end();) {
+    if (it->second.expired() && it->first != aot_library_path_) {
+      it = loaded_aot_data.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  auto& cached = loaded_aot_data[aot_library_path_];
+  if (auto aot_data = cached.lock()) {
+    return aot_data;
+  }
+
   FlutterEngineAOTDataSource source = {};
   source.type = kFlutterEngineAOTDataSourceTypeElfPath;
   source.elf_path = aot_library_path_.c_str();
@@ -82,7 +107,9 @@ UniqueAotDataPtr FlutterProjectBundle::LoadAotData(
     ELINUX_LOG(ERROR) << "Failed to load AOT data from: " << aot_library_path_;
     return nullptr;
   }
-  return UniqueAotDataPtr(data);
+  SharedAotDataPtr aot_data(data, AotDataDeleter());
+  cached = aot_data;
+  return aot_data;
 }
 
 const std::vector<std::string> FlutterProjectBundle::GetSwitches() {
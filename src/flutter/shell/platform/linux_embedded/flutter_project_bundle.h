@@ -20,6 +20,7 @@ struct AotDataDeleter {
   }
 };
 using UniqueAotDataPtr = std::unique_ptr<_FlutterEngineAOTData, AotDataDeleter>;
+using SharedAotDataPtr = std::shared_ptr<_FlutterEngineAOTData>;
 
 // The data associated with a Flutter project needed to run it in an engine.
 class FlutterProjectBundle {
@@ -48,8 +49,24 @@ class FlutterProjectBundle {
   // Attempts to load AOT data for this bundle. The returned data must be
   // retained until any engine instance it is passed to has been shut down.
   //
+  // Engines in the same process which use the same AOT library share one
+  // instance of its data.
+  //
   // Logs and returns nullptr on failure.
-  UniqueAotDataPtr LoadAotData(const FlutterEngineProcTable& engine_procs);
+  SharedAotDataPtr LoadAotData(const FlutterEngineProcTable& engine_procs);
+
+  // Returns the max size of the Dart old gen heap in MB requested by the
+  // properties: 0 for the VM's default, or
+  // kFlutterDesktopDartOldGenHeapSizeAuto.
+  int64_t dart_old_gen_heap_size() const { return dart_old_gen_heap_size_; }
+
+  // Returns the budget of the external texture memory in MB, or 0.
+  int64_t texture_memory_budget() const { return texture_memory_budget_; }
+
+  // Whether oversized pixel buffer textures are downscaled on the GPU.
+  bool downscale_external_textures() const {
+    return downscale_external_textures_;
+  }
 
   // Returns the command line arguments to be passed through to the Dart
   // entrypoint.
@@ -69,6 +86,12 @@ class FlutterProjectBundle {
 
   // Dart entrypoint arguments.
   std::vector<std::string> dart_entrypoint_arguments_;
+
+  int64_t dart_old_gen_heap_size_ = 0;
+
+  int64_t texture_memory_budget_ = 0;
+
+  bool downscale_external_textures_ = false;
 };
 
 }  // namespace flutter
@@ -40,6 +40,7 @@ constexpr char kUpdateEditingStateMethod[] =
 constexpr char kPerformActionMethod[] = "TextInputClient.performAction";
 
 constexpr char kTextInputAction[] = "inputAction";
+constexpr char kObscureText[] = "obscureText";
 constexpr char kTextInputType[] = "inputType";
 constexpr char kTextInputTypeName[] = "name";
 constexpr char kComposingBaseKey[] = "composingBase";
@@ -53,6 +54,12 @@ constexpr char kTextKey[] = "text";
 
 constexpr char kBadArgumentError[] = "Bad Arguments";
 constexpr char kInternalConsistencyError[] = "Internal Consistency Error";
+
+// The number of UTF-16 code units around the selection sent to the input
+// method. Input methods only need the context of the cursor, so the payload
+// doesn't grow with the document. This stays within the 4000 bytes that
+// text-input-unstable-v3 allows.
+constexpr size_t kSurroundingTextContext = 256;
 }  // namespace
 
 void TextInputPlugin::OnKeyPressed(uint32_t keycode, uint32_t code_point) {
@@ -95,6 +102,15 @@ void TextInputPlugin::OnKeyPressed(uint32_t keycode, uint32_t code_point) {
   }
 }
 
+void TextInputPlugin::DeleteSurrounding(int offset_from_cursor, int count) {
+  if (!active_model_) {
+    return;
+  }
+  if (active_model_->DeleteSurrounding(offset_from_cursor, count)) {
+    SendStateUpdate(*active_model_);
+  }
+}
+
 TextInputPlugin::TextInputPlugin(BinaryMessenger* messenger,
                                  WindowBindingHandler* delegate)
     : channel_(std::make_unique<flutter::MethodChannel<rapidjson::Document>>(
@@ -120,8 +136,10 @@ void TextInputPlugin::HandleMethodCall(
     delegate_->UpdateVirtualKeyboardStatus(true);
   } else if (method.compare(kHideMethod) == 0) {
     delegate_->UpdateVirtualKeyboardStatus(false);
+    ClearSurroundingText();
   } else if (method.compare(kClearClientMethod) == 0) {
     active_model_ = nullptr;
+    ClearSurroundingText();
   } else if (method.compare(kSetClientMethod) == 0) {
     if (!method_call.arguments() || method_call.arguments()->IsNull()) {
       result->Error(kBadArgumentError, "Method invoked without args");
@@ -160,6 +178,12 @@ void TextInputPlugin::HandleMethodCall(
         input_type_ = input_type_json->value.GetString();
       }
     }
+    obscure_text_ = false;
+    auto obscure_text_json = client_config.FindMember(kObscureText);
+    if (obscure_text_json != client_config.MemberEnd() &&
+        obscure_text_json->value.IsBool()) {
+      obscure_text_ = obscure_text_json->value.GetBool();
+    }
     active_model_ = std::make_unique<TextInputModel>();
   } else if (method.compare(kSetEditingStateMethod) == 0) {
     if (!method_call.arguments() || method_call.arguments()->IsNull()) {
@@ -197,6 +221,7 @@ void TextInputPlugin::HandleMethodCall(
     }
     active_model_->SetText(text->value.GetString());
     active_model_->SetSelection(TextRange(base, extent));
+    UpdateSurroundingText(*active_model_);
   } else {
     result->NotImplemented();
     return;
@@ -225,6 +250,23 @@ void TextInputPlugin::SendStateUpdate(const TextInputModel& model) {
   args->PushBack(editing_state, allocator);
 
   channel_->InvokeMethod(kUpdateEditingStateMethod, std::move(args));
+  UpdateSurroundingText(model);
+}
+
+void TextInputPlugin::UpdateSurroundingText(const TextInputModel& model) {
+  // Passwords must not leave the process.
+  if (obscure_text_) {
+    ClearSurroundingText();
+    return;
+  }
+  size_t cursor, anchor;
+  auto text =
+      model.GetSurroundingText(kSurroundingTextContext, &cursor, &anchor);
+  delegate_->UpdateVirtualKeyboardSurroundingText(text, cursor, anchor);
+}
+
+void TextInputPlugin::ClearSurroundingText() {
+  delegate_->UpdateVirtualKeyboardSurroundingText("", 0, 0);
 }
 
 void TextInputPlugin::EnterPressed(TextInputModel* model) {
@@ -23,10 +23,21 @@ class TextInputPlugin {
 
   void OnKeyPressed(uint32_t keycode, uint32_t code_point);
 
+  // Deletes text around the cursor of the active model on behalf of the input
+  // method. See TextInputModel::DeleteSurrounding.
+  void DeleteSurrounding(int offset_from_cursor, int count);
+
  private:
   // Sends the current state of the given model to the Flutter engine.
   void SendStateUpdate(const TextInputModel& model);
 
+  // Sends the text around the cursor of the given model to the input method.
+  // Nothing is sent for obscured text.
+  void UpdateSurroundingText(const TextInputModel& model);
+
+  // Clears the text known to the input method.
+  void ClearSurroundingText();
+
   // Sends an action triggered by the Enter key to the Flutter engine.
   void EnterPressed(TextInputModel* model);
 
@@ -48,6 +59,10 @@ class TextInputPlugin {
   // https://docs.flutter.io/flutter/services/TextInputType-class.html
   std::string input_type_;
 
+  // Whether the client edits a password, whose text is hidden from the input
+  // method.
+  bool obscure_text_ = false;
+
   // An action requested by the user on the input client. See available options:
   // https://docs.flutter.io/flutter/services/TextInputAction-class.html
   std::string input_action_;
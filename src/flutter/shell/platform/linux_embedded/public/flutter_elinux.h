@@ -52,8 +52,37 @@ typedef struct {
   // Array of Dart entrypoint arguments. This is deep copied during the call
   // to FlutterDesktopEngineCreate.
   const char** dart_entrypoint_argv;
+
+  // Max size of the Dart VM's old gen heap in MB. 0 keeps the Dart VM's
+  // default, and kFlutterDesktopDartOldGenHeapSizeAuto derives it from the
+  // memory limit of the process's cgroup (or the physical memory), so that the
+  // app is kept within its budget by the GC instead of the OOM killer.
+  int64_t dart_old_gen_heap_size;
+
+  // Budget in MB of the GPU memory used by external textures, or 0 for no
+  // limit. Past it, the storage of the least recently displayed pixel buffer
+  // and compressed pixel buffer textures is freed (and uploaded again when
+  // they are displayed), and new registrations fail if that isn't enough.
+  //
+  // Plugins aren't notified of evictions: an evicted texture calls its
+  // callback again the next time it's displayed, even if no new frame was
+  // marked available. So the callback must be able to return the current
+  // frame at any time, and plugins which free their pixels after a frame was
+  // copied must keep them instead when a budget is set.
+  int64_t texture_memory_budget;
+
+  // Downscales pixel buffer textures on the GPU when their buffers are much
+  // larger than displayed, so that the engine samples a texture of about the
+  // displayed size.
+  bool downscale_external_textures;
 } FlutterDesktopEngineProperties;
 
+// Special values of FlutterDesktopEngineProperties' dart_old_gen_heap_size.
+enum FlutterDesktopDartOldGenHeapSize {
+  // Lets the embedder choose the size from the available memory.
+  kFlutterDesktopDartOldGenHeapSizeAuto = -1,
+};
+
 // The View display mode.
 enum FlutterDesktopViewMode {
   // Shows the Flutter view by user specific size.
@@ -102,8 +131,101 @@ typedef struct {
   // Force scale factor specified by command line argument
   bool force_scale_factor;
   double scale_factor;
+
+  // Renders unrotated frames and lets the display hardware (the KMS plane
+  // rotation on DRM, the buffer transform on Wayland) apply `view_rotation`.
+  // If the display doesn't support it, the frames are rotated by the GPU.
+  bool use_display_rotation;
+
+  // Enables the variable refresh rate (adaptive sync) of the display if the
+  // panel supports it. This option is only active for DRM backends.
+  //
+  // With GBM, each frame is presented with a page flip instead of a mode set,
+  // so the panel refreshes when a frame arrives. The flip is waited for up to
+  // 1 second, after which the frame is presented with a mode set. With
+  // EGLStream, the driver presents the frames. In both cases, the engine
+  // still paces the frames with its own timer at the highest rate of the
+  // panel's range, which is sent again when a display is plugged in; the
+  // flip timestamps aren't fed back as vsync, since the DRM backends have no
+  // vsync callback.
+  bool use_variable_refresh_rate;
 } FlutterDesktopViewProperties;
 
+// The embedder regions whose heap allocations are accounted when the embedder
+// is built with ENABLE_ELINUX_ALLOCATION_TRACKER.
+enum FlutterDesktopAllocationRegion {
+  // Task queue bookkeeping and the closures posted to the platform task runner.
+  kFlutterDesktopAllocationRegionTaskRunner = 0,
+  // Routing of platform messages, including the internal plugin handlers.
+  kFlutterDesktopAllocationRegionMessageDispatcher = 1,
+  // The embedder side of presenting a frame.
+  kFlutterDesktopAllocationRegionPresent = 2,
+  // Vsync notification to the engine.
+  kFlutterDesktopAllocationRegionVsync = 3,
+  kFlutterDesktopAllocationRegionNum = 4,
+};
+
+// Runtime statistics of a Flutter engine instance.
+typedef struct {
+  // The size of this struct. Must be sizeof(FlutterDesktopEngineStats).
+  size_t struct_size;
+
+  // The frame and allocation counters below are process-wide: with several
+  // engines in the process, they add up the frames of all of them. The
+  // other fields are of this engine.
+
+  // Number of frames presented by this process.
+  uint64_t frame_count;
+
+  // Whether the allocation counters below are populated.
+  bool allocation_tracker_enabled;
+
+  // Heap allocations made by each region during the last presented frame.
+  uint64_t last_frame_allocation_counts[kFlutterDesktopAllocationRegionNum];
+  uint64_t last_frame_allocation_bytes[kFlutterDesktopAllocationRegionNum];
+
+  // Heap allocations made by each region since the process started.
+  uint64_t total_allocation_counts[kFlutterDesktopAllocationRegionNum];
+
+  // Max size of the Dart VM's old gen heap in MB passed to the engine, or 0
+  // if the Dart VM's default is used.
+  int64_t dart_old_gen_heap_size;
+
+  // Storage of unregistered pixel buffer textures kept for reuse, and the
+  // limits beyond which the least recently released textures are deleted.
+  uint64_t texture_pool_count;
+  uint64_t texture_pool_bytes;
+  uint64_t texture_pool_max_count;
+  uint64_t texture_pool_max_bytes;
+
+  // Pixel buffer textures whose storage was taken from the pool, and those
+  // which allocated new storage.
+  uint64_t texture_pool_hits;
+  uint64_t texture_pool_misses;
+
+  // Registered external textures, and the estimated GPU memory in bytes which
+  // backs them: textures uploaded by the embedder (pixel buffers and
+  // compressed pixel buffers), which can be evicted, and GL textures owned by
+  // the plugins.
+  uint64_t texture_count;
+  uint64_t pixel_buffer_texture_bytes;
+  uint64_t gpu_surface_texture_bytes;
+
+  // Budget of the external texture memory in bytes, or 0 if it's unlimited.
+  uint64_t texture_memory_budget;
+
+  // Times the storage of a texture was freed to stay within the budget.
+  uint64_t texture_evictions;
+
+  // Presented frames in which the present or vsync region allocated, not
+  // counting the first 60 frames. These regions run on every frame, so this
+  // stays at zero in steady state. Process-wide, like the other allocation
+  // counters. If the FLUTTER_ELINUX_FAIL_ON_FRAME_ALLOCATION environment
+  // variable is set, the first such frame aborts the process, so that test
+  // runs fail.
+  uint64_t allocating_frame_count;
+} FlutterDesktopEngineStats;
+
 // ========== View Controller ==========
 
 // Creates a view that hosts and displays the given engine instance.
@@ -124,6 +246,26 @@ FlutterDesktopViewControllerCreate(
     const FlutterDesktopViewProperties& view_properties,
     FlutterDesktopEngineRef engine);
 
+// Replaces the engine of |controller| with |engine|, e.g. to switch to another
+// application bundle without tearing down the display.
+//
+// The current engine is shut down and destroyed, which calls its plugin
+// registrar destruction callback. The view and its render surface are kept,
+// so the last frame stays on screen until |engine| presents its first frame.
+// Plugins have to be registered again with |engine|, and
+// FlutterDesktopEngineGetPollFds must be queried again.
+//
+// This takes ownership of |engine| in the same way as
+// FlutterDesktopViewControllerCreate, and starts it if it isn't running.
+//
+// Returns false if |engine| couldn't be started. The current engine has then
+// already been shut down, and |engine| is destroyed, so neither handle may be
+// used anymore. The controller is left without an engine: it can't dispatch
+// events, and must be destroyed with FlutterDesktopViewControllerDestroy.
+FLUTTER_EXPORT bool FlutterDesktopViewControllerReplaceEngine(
+    FlutterDesktopViewControllerRef controller,
+    FlutterDesktopEngineRef engine);
+
 // Shuts down the engine instance associated with |controller|, and cleans up
 // associated state.
 //
@@ -141,6 +283,14 @@ FLUTTER_EXPORT FlutterDesktopEngineRef FlutterDesktopViewControllerGetEngine(
 FLUTTER_EXPORT FlutterDesktopViewRef
 FlutterDesktopViewControllerGetView(FlutterDesktopViewControllerRef controller);
 
+// Dispatches the pending events of the display and input devices of |view|
+// without blocking. Returns false if the display connection was lost.
+//
+// Hosts waiting on FlutterDesktopEngineGetPollFds() must not read the fds
+// themselves: this does the reading. With Wayland, it prepares the read of
+// the window's event queue, flushes the pending requests, reads the events if
+// the connection fd is readable and cancels the read otherwise, so that
+// events read by other windows on the connection are dispatched too.
 FLUTTER_EXPORT bool FlutterDesktopViewDispatchEvent(FlutterDesktopViewRef view);
 
 // Returns the display frame rate by the given controller.
@@ -183,6 +333,31 @@ FLUTTER_EXPORT bool FlutterDesktopEngineRun(FlutterDesktopEngineRef engine,
 FLUTTER_EXPORT uint64_t
 FlutterDesktopEngineProcessMessages(FlutterDesktopEngineRef engine);
 
+// Copies up to |fds_size| file descriptors into |fds| and returns the total
+// number of file descriptors, so |fds| may be null to query the count.
+//
+// These let a host with its own event loop (GLib, libuv, Qt, ...) drive the
+// engine without polling: wait until any of them is readable (POLLIN) or
+// FlutterDesktopEngineGetNextTimeout() expires, then call
+// FlutterDesktopViewDispatchEvent() and FlutterDesktopEngineProcessMessages().
+// The set includes the view's display and input fds, so query it again after
+// creating the view controller.
+//
+// FlutterDesktopViewDispatchEvent() must also be called once before the first
+// wait, and the fds must only be read by it. On Wayland, it flushes the
+// requests the wait would otherwise stall, and dispatches the events already
+// queued, which don't make the connection fd readable again.
+FLUTTER_EXPORT size_t FlutterDesktopEngineGetPollFds(
+    FlutterDesktopEngineRef engine,
+    int* fds,
+    size_t fds_size);
+
+// Returns the number of nanoseconds until the next scheduled event without
+// processing anything. Zero means an event is already due, and UINT64_MAX
+// means that none is scheduled, i.e. that the wait has no timeout.
+FLUTTER_EXPORT uint64_t
+FlutterDesktopEngineGetNextTimeout(FlutterDesktopEngineRef engine);
+
 FLUTTER_EXPORT void FlutterDesktopEngineReloadSystemFonts(
     FlutterDesktopEngineRef engine);
 
@@ -201,6 +376,127 @@ FlutterDesktopEngineGetMessenger(FlutterDesktopEngineRef engine);
 FLUTTER_EXPORT FlutterDesktopTextureRegistrarRef
 FlutterDesktopEngineGetTextureRegistrar(FlutterDesktopEngineRef engine);
 
+// Fills |stats| with the runtime statistics of |engine|. |stats->struct_size|
+// must be set by the caller.
+//
+// Returns false if |stats| is null or has an unexpected struct size.
+FLUTTER_EXPORT bool FlutterDesktopEngineGetStats(
+    FlutterDesktopEngineRef engine,
+    FlutterDesktopEngineStats* stats);
+
+// Posts |callback| to the engine's raster thread, where it's called with
+// |user_data| while a GL context of the engine's share group is current. This
+// is the place for GL work of textures which doesn't belong in the
+// frame-critical texture callbacks. The callback must leave the context
+// current.
+//
+// Returns false if the engine isn't running.
+FLUTTER_EXPORT bool FlutterDesktopTextureRegistrarPostRasterThreadTask(
+    FlutterDesktopTextureRegistrarRef texture_registrar,
+    void (*callback)(void* user_data),
+    void* user_data);
+
+// ========== Shared GL context ==========
+
+// Opaque reference to a plugin-owned EGL context which shares GL objects with
+// the engine's contexts.
+struct FlutterDesktopGlContext;
+typedef struct FlutterDesktopGlContext* FlutterDesktopGlContextRef;
+
+// A GL texture rendered by a plugin with a FlutterDesktopGlContextRef. This is
+// referenced by |FlutterDesktopGpuSurfaceDescriptor::handle| when registering
+// a |kFlutterDesktopGpuSurfaceTypeGlTexture| texture.
+typedef struct {
+  // The size of this struct. Must be sizeof(FlutterDesktopGlTexture).
+  size_t struct_size;
+  // The GL texture name. The texture is owned by the plugin.
+  uint32_t name;
+  // The GL texture target. GL_TEXTURE_2D is used if this is zero.
+  uint32_t target;
+  // The sized internal format. GL_RGBA8 is used if this is zero.
+  uint32_t format;
+  // The fence created by FlutterDesktopGlContextCreateFence after rendering
+  // the frame, or null. The embedder takes ownership of the fence and waits on
+  // it GPU-side before the engine samples the texture. The embedder doesn't
+  // modify this struct, so a fence must be returned only once: replace or
+  // clear it before returning the struct again.
+  void* fence;
+} FlutterDesktopGlTexture;
+
+// Creates an EGL context shared with the engine's resource context.
+//
+// The context can be made current on any one thread at a time. It must be
+// destroyed before the engine is shut down. Returns a null pointer if the
+// platform doesn't support it.
+FLUTTER_EXPORT FlutterDesktopGlContextRef
+FlutterDesktopTextureRegistrarCreateSharedGlContext(
+    FlutterDesktopTextureRegistrarRef texture_registrar);
+
+// Destroys the given context.
+FLUTTER_EXPORT void FlutterDesktopGlContextDestroy(
+    FlutterDesktopGlContextRef context);
+
+// Makes the given context current on the calling thread.
+FLUTTER_EXPORT bool FlutterDesktopGlContextMakeCurrent(
+    FlutterDesktopGlContextRef context);
+
+// Releases the given context from the calling thread.
+FLUTTER_EXPORT bool FlutterDesktopGlContextClearCurrent(
+    FlutterDesktopGlContextRef context);
+
+// Returns the address of the GL function named |name|.
+FLUTTER_EXPORT void* FlutterDesktopGlContextGetProcAddress(
+    FlutterDesktopGlContextRef context,
+    const char* name);
+
+// Creates a fence for the GL commands issued so far on |context|, which must
+// be current on the calling thread. Set the result to
+// |FlutterDesktopGlTexture::fence| to publish the frame. Returns null on error,
+// including when EGL_KHR_fence_sync isn't supported.
+FLUTTER_EXPORT void* FlutterDesktopGlContextCreateFence(
+    FlutterDesktopGlContextRef context);
+
+// ========== Compressed pixel buffers ==========
+
+// Pre-compressed image data uploaded by the embedder. This is referenced by
+// |FlutterDesktopGpuSurfaceDescriptor::handle| when registering a
+// |kFlutterDesktopGpuSurfaceTypeCompressedPixelBuffer| texture, whose
+// descriptor gives the size of the image in |width| and |height|.
+//
+// The data is uploaded each time the descriptor is obtained, i.e. once for
+// static content, and can be released from the descriptor's
+// |release_callback|. If the GPU supports the format, the data is uploaded as
+// is with glCompressedTexImage2D and the engine samples the compressed
+// texture, which takes the compressed size in GPU memory. Otherwise ETC1, ETC2
+// and BC1 data is decoded to RGBA on the CPU, which only saves the memory of
+// the plugin's buffers.
+typedef struct {
+  // The size of this struct. Must be
+  // sizeof(FlutterDesktopCompressedPixelBuffer).
+  size_t struct_size;
+  // The GL internal format of the data: GL_COMPRESSED_RGB8_ETC2,
+  // GL_ETC1_RGB8_OES, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+  // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, or GL_COMPRESSED_RGBA_ASTC_4x4_KHR to
+  // GL_COMPRESSED_RGBA_ASTC_12x12_KHR. ASTC data has no software decoder, so
+  // it must be supported according to
+  // FlutterDesktopTextureRegistrarIsCompressedFormatSupported.
+  uint32_t format;
+  // The compressed data of the first mip level.
+  const uint8_t* data;
+  // The size of |data| in bytes.
+  size_t data_size;
+} FlutterDesktopCompressedPixelBuffer;
+
+// Returns true if the GPU supports compressed pixel buffers of the GL internal
+// |format|, so that they stay compressed in GPU memory. Producers can use it
+// to pick a format the GPU supports (e.g. ASTC with
+// KHR_texture_compression_astc_ldr, ETC2 with GLES 3, or ETC1 with its
+// extension). The formats are queried on the engine's GL context, so this
+// returns false until the engine has started rendering.
+FLUTTER_EXPORT bool FlutterDesktopTextureRegistrarIsCompressedFormatSupported(
+    FlutterDesktopTextureRegistrarRef texture_registrar,
+    uint32_t format);
+
 #if defined(__cplusplus)
 }  // extern "C"
 #endif
@@ -4,11 +4,27 @@
 
 #include "flutter/shell/platform/linux_embedded/surface/context_egl.h"
 
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "flutter/shell/platform/linux_embedded/logger.h"
 #include "flutter/shell/platform/linux_embedded/surface/egl_utils.h"
 
 namespace flutter {
 
+namespace {
+
+// The resource contexts alive on each EGLDisplay. All contexts created on a
+// display join one share group, so that engines running in the same process
+// (e.g. one per view) share GPU resources such as uploaded images and
+// compiled shaders instead of each keeping their own copy.
+std::mutex share_group_mutex;
+std::unordered_map<EGLDisplay, std::vector<EGLContext>> share_group_contexts;
+
+}  // namespace
+
 ContextEgl::ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
                        EGLint egl_surface_type)
     : environment_(std::move(environment)), config_(nullptr) {
@@ -41,9 +57,28 @@ ContextEgl::ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
   }
 
   {
+    std::lock_guard<std::mutex> lock(share_group_mutex);
+    auto& share_group = share_group_contexts[environment_->Display()];
+    // The oldest context stays in the group for longest, whereas the newest
+    // may belong to an engine which is about to be shut down.
+    auto share_context =
+        share_group.empty() ? EGL_NO_CONTEXT : share_group.front();
+
     const EGLint attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
     context_ = eglCreateContext(environment_->Display(), config_,
-                                EGL_NO_CONTEXT, attribs);
+                                share_context, attribs);
+    bool shared = share_context != EGL_NO_CONTEXT;
+    if (context_ == EGL_NO_CONTEXT && shared) {
+      // Contexts with incompatible configs (EGL_BAD_MATCH) can't share. Fall
+      // back to a share group of this engine's own.
+      auto error = eglGetError();
+      ELINUX_LOG(WARNING) << "Failed to share the GL context with other "
+                          << "engines (0x" << std::hex << error << std::dec
+                          << "), their textures won't be shared.";
+      context_ = eglCreateContext(environment_->Display(), config_,
+                                  EGL_NO_CONTEXT, attribs);
+      shared = false;
+    }
     if (context_ == EGL_NO_CONTEXT) {
       ELINUX_LOG(ERROR) << "Failed to create an onscreen context: "
                         << get_egl_error_cause();
@@ -57,11 +92,32 @@ ContextEgl::ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
                         << get_egl_error_cause();
       return;
     }
+    if (shared || share_group.empty()) {
+      share_group.push_back(resource_context_);
+    }
   }
 
   valid_ = true;
 }
 
+ContextEgl::~ContextEgl() {
+  auto display = environment_->Display();
+  std::lock_guard<std::mutex> lock(share_group_mutex);
+  if (resource_context_ != EGL_NO_CONTEXT) {
+    auto& share_group = share_group_contexts[display];
+    share_group.erase(
+        std::remove(share_group.begin(), share_group.end(), resource_context_),
+        share_group.end());
+    if (share_group.empty()) {
+      share_group_contexts.erase(display);
+    }
+    eglDestroyContext(display, resource_context_);
+  }
+  if (context_ != EGL_NO_CONTEXT) {
+    eglDestroyContext(display, context_);
+  }
+}
+
 std::unique_ptr<ELinuxEGLSurface> ContextEgl::CreateOnscreenSurface(
     NativeWindow* window) const {
   const EGLint attribs[] = {EGL_NONE};
@@ -107,6 +163,18 @@ std::unique_ptr<ELinuxEGLSurface> ContextEgl::CreateOffscreenSurface(
                                             resource_context_);
 }
 
+std::unique_ptr<ContextEglShared> ContextEgl::CreateSharedContext() const {
+  if (!valid_) {
+    return nullptr;
+  }
+  auto context = std::make_unique<ContextEglShared>(
+      environment_->Display(), config_, resource_context_);
+  if (!context->IsValid()) {
+    return nullptr;
+  }
+  return context;
+}
+
 bool ContextEgl::IsValid() const {
   return valid_;
 }
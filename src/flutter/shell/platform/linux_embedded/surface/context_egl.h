@@ -9,6 +9,7 @@
 
 #include <memory>
 
+#include "flutter/shell/platform/linux_embedded/surface/context_egl_shared.h"
 #include "flutter/shell/platform/linux_embedded/surface/elinux_egl_surface.h"
 #include "flutter/shell/platform/linux_embedded/surface/environment_egl.h"
 #include "flutter/shell/platform/linux_embedded/window/native_window.h"
@@ -19,7 +20,7 @@ class ContextEgl {
  public:
   ContextEgl(std::unique_ptr<EnvironmentEgl> environment,
              EGLint egl_surface_type = EGL_WINDOW_BIT);
-  ~ContextEgl() = default;
+  virtual ~ContextEgl();
 
   virtual std::unique_ptr<ELinuxEGLSurface> CreateOnscreenSurface(
       NativeWindow* window) const;
@@ -27,6 +28,9 @@ class ContextEgl {
   std::unique_ptr<ELinuxEGLSurface> CreateOffscreenSurface(
       NativeWindow* window_resource) const;
 
+  // Creates a context which shares GL objects with the engine's contexts.
+  std::unique_ptr<ContextEglShared> CreateSharedContext() const;
+
   bool IsValid() const;
 
   bool ClearCurrent() const;
@@ -38,9 +42,9 @@ class ContextEgl {
  protected:
   std::unique_ptr<EnvironmentEgl> environment_;
   EGLConfig config_;
-  EGLContext context_;
-  EGLContext resource_context_;
-  bool valid_;
+  EGLContext context_ = EGL_NO_CONTEXT;
+  EGLContext resource_context_ = EGL_NO_CONTEXT;
+  bool valid_ = false;
 };
 
 }  // namespace flutter
@@ -0,0 +1,106 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/surface/context_egl_shared.h"
+
+#include "flutter/shell/platform/linux_embedded/logger.h"
+#include "flutter/shell/platform/linux_embedded/surface/egl_utils.h"
+
+namespace flutter {
+
+ContextEglShared::ContextEglShared(EGLDisplay display,
+                                   EGLConfig config,
+                                   EGLContext share_context)
+    : display_(display) {
+  // Only needed by CreateFence, which checks them.
+  if (has_egl_extension(display_, "EGL_KHR_fence_sync")) {
+    egl_create_sync_khr_ = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+        eglGetProcAddress("eglCreateSyncKHR"));
+    gl_flush_ = reinterpret_cast<void (*)()>(eglGetProcAddress("glFlush"));
+  }
+
+  const EGLint attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+  context_ = eglCreateContext(display_, config, share_context, attribs);
+  if (context_ == EGL_NO_CONTEXT) {
+    ELINUX_LOG(ERROR) << "Failed to create a shared context: "
+                      << get_egl_error_cause();
+    return;
+  }
+
+  // Plugins render into FBOs backed by their textures, so the context doesn't
+  // need a drawable as long as the driver allows it.
+  if (!has_egl_extension(display_, "EGL_KHR_surfaceless_context")) {
+    const EGLint surface_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    surface_ = eglCreatePbufferSurface(display_, config, surface_attribs);
+    if (surface_ == EGL_NO_SURFACE) {
+      ELINUX_LOG(ERROR) << "Neither surfaceless contexts nor pbuffers are "
+                           "supported: "
+                        << get_egl_error_cause();
+      return;
+    }
+  }
+
+  valid_ = true;
+}
+
+ContextEglShared::~ContextEglShared() {
+  if (eglGetCurrentContext() == context_) {
+    ClearCurrent();
+  }
+  if (surface_ != EGL_NO_SURFACE) {
+    eglDestroySurface(display_, surface_);
+  }
+  if (context_ != EGL_NO_CONTEXT) {
+    eglDestroyContext(display_, context_);
+  }
+}
+
+bool ContextEglShared::IsValid() const {
+  return valid_;
+}
+
+bool ContextEglShared::MakeCurrent() const {
+  if (eglMakeCurrent(display_, surface_, surface_, context_) != EGL_TRUE) {
+    ELINUX_LOG(ERROR) << "Failed to make the shared context current: "
+                      << get_egl_error_cause();
+    return false;
+  }
+  return true;
+}
+
+bool ContextEglShared::ClearCurrent() const {
+  if (eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                     EGL_NO_CONTEXT) != EGL_TRUE) {
+    ELINUX_LOG(ERROR) << "Failed to clear the shared context: "
+                      << get_egl_error_cause();
+    return false;
+  }
+  return true;
+}
+
+void* ContextEglShared::GlProcResolver(const char* name) const {
+  return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+EGLSyncKHR ContextEglShared::CreateFence() const {
+  if (!egl_create_sync_khr_ || !gl_flush_) {
+    ELINUX_LOG(ERROR) << "EGL_KHR_fence_sync isn't supported.";
+    return EGL_NO_SYNC_KHR;
+  }
+  if (eglGetCurrentContext() != context_) {
+    ELINUX_LOG(ERROR) << "The shared context isn't current.";
+    return EGL_NO_SYNC_KHR;
+  }
+  EGLSyncKHR fence =
+      egl_create_sync_khr_(display_, EGL_SYNC_FENCE_KHR, nullptr);
+  if (fence == EGL_NO_SYNC_KHR) {
+    ELINUX_LOG(ERROR) << "Failed to create a fence: " << get_egl_error_cause();
+    return EGL_NO_SYNC_KHR;
+  }
+  // The fence must reach the GPU before other contexts can wait on it.
+  gl_flush_();
+  return fence;
+}
+
+}  // namespace flutter
@@ -0,0 +1,58 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_CONTEXT_EGL_SHARED_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_CONTEXT_EGL_SHARED_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace flutter {
+
+// An EGL context which shares its GL objects with the engine's contexts.
+// This is handed to plugins which render to GL textures on their own threads.
+// The frames are published to the engine with fences, which the embedder waits
+// on GPU-side before sampling the textures.
+class ContextEglShared {
+ public:
+  ContextEglShared(EGLDisplay display,
+                   EGLConfig config,
+                   EGLContext share_context);
+  ~ContextEglShared();
+
+  // Prevent copying.
+  ContextEglShared(ContextEglShared const&) = delete;
+  ContextEglShared& operator=(ContextEglShared const&) = delete;
+
+  bool IsValid() const;
+
+  bool MakeCurrent() const;
+
+  bool ClearCurrent() const;
+
+  void* GlProcResolver(const char* name) const;
+
+  // Inserts a fence after the commands issued so far on this context and
+  // flushes them. This context must be current on the calling thread.
+  // Returns EGL_NO_SYNC_KHR on error, including when EGL_KHR_fence_sync isn't
+  // supported.
+  EGLSyncKHR CreateFence() const;
+
+ private:
+  EGLDisplay display_;
+  EGLContext context_ = EGL_NO_CONTEXT;
+
+  // A dummy surface only used when EGL_KHR_surfaceless_context isn't
+  // supported.
+  EGLSurface surface_ = EGL_NO_SURFACE;
+
+  // Resolved only if EGL_KHR_fence_sync is supported.
+  PFNEGLCREATESYNCKHRPROC egl_create_sync_khr_ = nullptr;
+  void (*gl_flush_)() = nullptr;
+  bool valid_ = false;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_CONTEXT_EGL_SHARED_H_
@@ -7,6 +7,7 @@
 
 #include <EGL/egl.h>
 
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -40,4 +41,19 @@ std::string get_egl_error_cause() {
   return nullptr;
 }
 
+bool has_egl_extension(EGLDisplay display, const char* name) {
+  const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!extensions) {
+    return false;
+  }
+  const size_t length = strlen(name);
+  for (const char* p = strstr(extensions, name); p; p = strstr(p + 1, name)) {
+    if ((p == extensions || p[-1] == ' ') &&
+        (p[length] == ' ' || p[length] == '\0')) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace flutter
\ No newline at end of file
@@ -5,12 +5,19 @@
 #ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_EGL_UTILS_H_
 #define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_EGL_UTILS_H_
 
+#include <EGL/egl.h>
+
 #include <string>
 
 namespace flutter {
 
 std::string get_egl_error_cause();
 
+// Returns true if |name| is in the extension string of |display|. A function
+// of an extension may resolve with eglGetProcAddress even when the extension
+// isn't supported, so this must be checked before using it.
+bool has_egl_extension(EGLDisplay display, const char* name);
+
 }  // namespace flutter
 
 #endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_EGL_UTILS_H_
\ No newline at end of file
@@ -7,6 +7,9 @@
 
 #include <EGL/egl.h>
 
+#include <mutex>
+#include <unordered_map>
+
 #include "flutter/shell/platform/linux_embedded/logger.h"
 #include "flutter/shell/platform/linux_embedded/surface/egl_utils.h"
 
@@ -38,20 +41,37 @@ class EnvironmentEgl {
       : display_(EGL_NO_DISPLAY), sub_environment_(sub_environment) {}
 
   ~EnvironmentEgl() {
-    if (display_ != EGL_NO_DISPLAY && !sub_environment_) {
-      if (eglTerminate(display_) != EGL_TRUE) {
-        ELINUX_LOG(ERROR) << "Failed to terminate the EGL display: "
-                          << get_egl_error_cause();
+    if (display_ != EGL_NO_DISPLAY && initialized_) {
+      std::lock_guard<std::mutex> lock(DisplayUsersMutex());
+      auto& users = DisplayUsers();
+      if (--users[display_] == 0) {
+        users.erase(display_);
+        if (eglTerminate(display_) != EGL_TRUE) {
+          ELINUX_LOG(ERROR) << "Failed to terminate the EGL display: "
+                            << get_egl_error_cause();
+        }
       }
       display_ = EGL_NO_DISPLAY;
     }
   }
 
-  bool InitializeEgl() const {
-    if (eglInitialize(display_, nullptr, nullptr) != EGL_TRUE) {
-      ELINUX_LOG(ERROR) << "Failed to initialize the EGL display: "
-                        << get_egl_error_cause();
-      return false;
+  bool InitializeEgl() {
+    {
+      // Views in one process may get the same EGLDisplay (e.g. when they share
+      // a Wayland connection), and eglTerminate would tear it down for all of
+      // them. So it's initialized by its first user and terminated by the
+      // last one.
+      std::lock_guard<std::mutex> lock(DisplayUsersMutex());
+      auto& users = DisplayUsers();
+      if (users[display_] == 0 &&
+          eglInitialize(display_, nullptr, nullptr) != EGL_TRUE) {
+        ELINUX_LOG(ERROR) << "Failed to initialize the EGL display: "
+                          << get_egl_error_cause();
+        users.erase(display_);
+        return false;
+      }
+      users[display_]++;
+      initialized_ = true;
     }
 
     if (eglBindAPI(EGL_OPENGL_ES_API) != EGL_TRUE) {
@@ -70,6 +90,20 @@ class EnvironmentEgl {
   EGLDisplay display_;
   bool valid_ = false;
   bool sub_environment_;
+
+ private:
+  // The number of environments which initialized each EGLDisplay.
+  static std::unordered_map<EGLDisplay, int>& DisplayUsers() {
+    static std::unordered_map<EGLDisplay, int> users;
+    return users;
+  }
+
+  static std::mutex& DisplayUsersMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  bool initialized_ = false;
 };
 
 }  // namespace flutter
@@ -64,4 +64,8 @@ bool SurfaceBase::ResourceContextMakeCurrent() const {
   return offscreen_surface_->MakeCurrent();
 };
 
+std::unique_ptr<ContextEglShared> SurfaceBase::CreateSharedContext() const {
+  return context_->CreateSharedContext();
+};
+
 }  // namespace flutter
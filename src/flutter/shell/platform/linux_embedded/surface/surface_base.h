@@ -39,6 +39,9 @@ class SurfaceBase {
   // Makes an off-screen resource context.
   bool ResourceContextMakeCurrent() const;
 
+  // Creates a context for plugins which shares GL objects with the engine.
+  std::unique_ptr<ContextEglShared> CreateSharedContext() const;
+
  protected:
   std::unique_ptr<ContextEgl> context_;
   NativeWindow* native_window_ = nullptr;
@@ -19,7 +19,8 @@ bool SurfaceGl::GLContextClearCurrent() const {
 }
 
 bool SurfaceGl::GLContextPresent(uint32_t fbo_id) const {
-  if (!onscreen_surface_->SwapBuffers()) {
+  if (!native_window_->RendersToFramebuffer() &&
+      !onscreen_surface_->SwapBuffers()) {
     return false;
   }
   native_window_->SwapBuffers();
@@ -27,7 +28,11 @@ bool SurfaceGl::GLContextPresent(uint32_t fbo_id) const {
 }
 
 uint32_t SurfaceGl::GLContextFBO() const {
-  return 0;
+  return native_window_->Framebuffer();
+}
+
+bool SurfaceGl::RendersToFramebuffer() const {
+  return native_window_ && native_window_->RendersToFramebuffer();
 }
 
 void* SurfaceGl::GlProcResolver(const char* name) const {
@@ -32,6 +32,10 @@ class SurfaceGl final : public SurfaceBase, public SurfaceGlDelegate {
 
   // |SurfaceGlDelegate|
   void* GlProcResolver(const char* name) const override;
+
+  // Returns true if the window renders each frame into a framebuffer object
+  // of its own instead of the default framebuffer of the EGL surface.
+  bool RendersToFramebuffer() const;
 };
 
 }  // namespace flutter
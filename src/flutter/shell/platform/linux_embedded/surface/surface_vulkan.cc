@@ -0,0 +1,471 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/surface/surface_vulkan.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "flutter/shell/platform/linux_embedded/logger.h"
+
+namespace flutter {
+
+namespace {
+// The engine's Vulkan backend requires Vulkan 1.1.
+constexpr uint32_t kVulkanApiVersion = VK_API_VERSION_1_1;
+
+// Returns a score of the physical device type, preferring real GPUs over
+// software implementations such as lavapipe.
+int GetDeviceTypeScore(VkPhysicalDeviceType type) {
+  switch (type) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      return 3;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+      return 2;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      return 0;
+    default:
+      return 1;
+  }
+}
+}  // namespace
+
+SurfaceVulkan::SurfaceVulkan(wl_display* display) : wl_display_(display) {
+  instance_extensions_ = {
+      VK_KHR_SURFACE_EXTENSION_NAME,
+      VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME,
+  };
+  device_extensions_ = {
+      VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+  };
+  CreateInstance();
+}
+
+SurfaceVulkan::~SurfaceVulkan() {
+  if (device_ != VK_NULL_HANDLE) {
+    vkDeviceWaitIdle(device_);
+    DestroySwapchain();
+    if (image_ready_fence_ != VK_NULL_HANDLE) {
+      vkDestroyFence(device_, image_ready_fence_, nullptr);
+    }
+    if (command_pool_ != VK_NULL_HANDLE) {
+      vkDestroyCommandPool(device_, command_pool_, nullptr);
+    }
+    vkDestroyDevice(device_, nullptr);
+  }
+  if (surface_ != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(instance_, surface_, nullptr);
+  }
+  if (instance_ != VK_NULL_HANDLE) {
+    vkDestroyInstance(instance_, nullptr);
+  }
+}
+
+bool SurfaceVulkan::IsValid() const {
+  return valid_;
+}
+
+bool SurfaceVulkan::SetNativeWindow(NativeWindowWayland* window) {
+  if (instance_ == VK_NULL_HANDLE) {
+    return false;
+  }
+  native_window_ = window;
+
+  VkWaylandSurfaceCreateInfoKHR surface_info = {};
+  surface_info.sType = VK_STRUCTURE_TYPE_WAYLAND_SURFACE_CREATE_INFO_KHR;
+  surface_info.display = wl_display_;
+  surface_info.surface = native_window_->Surface();
+  if (vkCreateWaylandSurfaceKHR(instance_, &surface_info, nullptr,
+                                &surface_) != VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to create the Vulkan surface.";
+    return false;
+  }
+
+  if (!CreateDevice()) {
+    return false;
+  }
+
+  if (!CreateSwapchain(native_window_->Width(), native_window_->Height())) {
+    return false;
+  }
+
+  valid_ = true;
+  return true;
+}
+
+bool SurfaceVulkan::OnScreenSurfaceResize(const size_t width,
+                                          const size_t height) {
+  return native_window_->Resize(width, height);
+}
+
+void SurfaceVulkan::GetRendererConfig(
+    FlutterVulkanRendererConfig* config) const {
+  config->version = kVulkanApiVersion;
+  config->instance = instance_;
+  config->physical_device = physical_device_;
+  config->device = device_;
+  config->queue_family_index = queue_family_index_;
+  config->queue = queue_;
+  config->enabled_instance_extension_count = instance_extensions_.size();
+  config->enabled_instance_extensions =
+      const_cast<const char**>(instance_extensions_.data());
+  config->enabled_device_extension_count = device_extensions_.size();
+  config->enabled_device_extensions =
+      const_cast<const char**>(device_extensions_.data());
+}
+
+void* SurfaceVulkan::GetInstanceProcAddress(VkInstance instance,
+                                            const char* name) const {
+  // vkGetInstanceProcAddr itself can't be resolved through the loader.
+  if (std::strcmp(name, "vkGetInstanceProcAddr") == 0) {
+    return reinterpret_cast<void*>(vkGetInstanceProcAddr);
+  }
+  return reinterpret_cast<void*>(vkGetInstanceProcAddr(instance, name));
+}
+
+FlutterVulkanImage SurfaceVulkan::AcquireNextImage(size_t width,
+                                                   size_t height) {
+  FlutterVulkanImage image = {};
+  image.struct_size = sizeof(FlutterVulkanImage);
+
+  if (swapchain_out_of_date_ || swapchain_extent_.width != width ||
+      swapchain_extent_.height != height) {
+    vkDeviceWaitIdle(device_);
+    if (!CreateSwapchain(width, height)) {
+      return image;
+    }
+  }
+
+  auto result =
+      vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, VK_NULL_HANDLE,
+                            image_ready_fence_, &last_image_index_);
+  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+    vkDeviceWaitIdle(device_);
+    if (!CreateSwapchain(width, height)) {
+      return image;
+    }
+    result =
+        vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, VK_NULL_HANDLE,
+                              image_ready_fence_, &last_image_index_);
+  }
+  if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+    ELINUX_LOG(ERROR) << "Failed to acquire the next image: " << result;
+    return image;
+  }
+  swapchain_out_of_date_ = (result == VK_SUBOPTIMAL_KHR);
+
+  // The engine renders into the image as soon as it's returned.
+  vkWaitForFences(device_, 1, &image_ready_fence_, VK_TRUE, UINT64_MAX);
+  vkResetFences(device_, 1, &image_ready_fence_);
+
+  image.image = reinterpret_cast<FlutterVulkanImageHandle>(
+      swapchain_images_[last_image_index_]);
+  image.format = surface_format_.format;
+  return image;
+}
+
+bool SurfaceVulkan::Present(const FlutterVulkanImage* image) {
+  // The engine has already waited for the rendering on the host, so only the
+  // layout transition needs to be ordered before the presentation.
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &present_transition_buffers_[last_image_index_];
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &present_ready_semaphores_[last_image_index_];
+  if (vkQueueSubmit(queue_, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to submit the layout transition.";
+    return false;
+  }
+
+  VkPresentInfoKHR present_info = {};
+  present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+  present_info.waitSemaphoreCount = 1;
+  present_info.pWaitSemaphores = &present_ready_semaphores_[last_image_index_];
+  present_info.swapchainCount = 1;
+  present_info.pSwapchains = &swapchain_;
+  present_info.pImageIndices = &last_image_index_;
+  auto result = vkQueuePresentKHR(queue_, &present_info);
+  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+    swapchain_out_of_date_ = true;
+    return true;
+  }
+  if (result != VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to present the image: " << result;
+    return false;
+  }
+  return true;
+}
+
+bool SurfaceVulkan::CreateInstance() {
+  VkApplicationInfo app_info = {};
+  app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  app_info.pApplicationName = "Flutter";
+  app_info.pEngineName = "Flutter";
+  app_info.apiVersion = kVulkanApiVersion;
+
+  VkInstanceCreateInfo instance_info = {};
+  instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  instance_info.pApplicationInfo = &app_info;
+  instance_info.enabledExtensionCount = instance_extensions_.size();
+  instance_info.ppEnabledExtensionNames = instance_extensions_.data();
+  auto result = vkCreateInstance(&instance_info, nullptr, &instance_);
+  if (result != VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to create the Vulkan instance: " << result;
+    instance_ = VK_NULL_HANDLE;
+    return false;
+  }
+  return true;
+}
+
+bool SurfaceVulkan::CreateDevice() {
+  uint32_t device_count = 0;
+  vkEnumeratePhysicalDevices(instance_, &device_count, nullptr);
+  std::vector<VkPhysicalDevice> devices(device_count);
+  vkEnumeratePhysicalDevices(instance_, &device_count, devices.data());
+
+  int best_score = -1;
+  for (auto device : devices) {
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count,
+                                             families.data());
+    for (uint32_t i = 0; i < family_count; i++) {
+      VkBool32 present_supported = VK_FALSE;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_,
+                                           &present_supported);
+      if (!(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) ||
+          !present_supported) {
+        continue;
+      }
+
+      VkPhysicalDeviceProperties properties;
+      vkGetPhysicalDeviceProperties(device, &properties);
+      auto score = GetDeviceTypeScore(properties.deviceType);
+      if (score > best_score) {
+        best_score = score;
+        physical_device_ = device;
+        queue_family_index_ = i;
+      }
+      break;
+    }
+  }
+  if (physical_device_ == VK_NULL_HANDLE) {
+    ELINUX_LOG(ERROR) << "No Vulkan device can present to the surface.";
+    return false;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physical_device_, &properties);
+  ELINUX_LOG(INFO) << "Vulkan device: " << properties.deviceName;
+
+  const float priority = 1.0f;
+  VkDeviceQueueCreateInfo queue_info = {};
+  queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queue_info.queueFamilyIndex = queue_family_index_;
+  queue_info.queueCount = 1;
+  queue_info.pQueuePriorities = &priority;
+
+  VkDeviceCreateInfo device_info = {};
+  device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  device_info.queueCreateInfoCount = 1;
+  device_info.pQueueCreateInfos = &queue_info;
+  device_info.enabledExtensionCount = device_extensions_.size();
+  device_info.ppEnabledExtensionNames = device_extensions_.data();
+  auto result =
+      vkCreateDevice(physical_device_, &device_info, nullptr, &device_);
+  if (result != VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to create the Vulkan device: " << result;
+    device_ = VK_NULL_HANDLE;
+    return false;
+  }
+  vkGetDeviceQueue(device_, queue_family_index_, 0, &queue_);
+
+  VkCommandPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  pool_info.queueFamilyIndex = queue_family_index_;
+  if (vkCreateCommandPool(device_, &pool_info, nullptr, &command_pool_) !=
+      VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to create the command pool.";
+    return false;
+  }
+
+  VkFenceCreateInfo fence_info = {};
+  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  if (vkCreateFence(device_, &fence_info, nullptr, &image_ready_fence_) !=
+      VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to create the fence.";
+    return false;
+  }
+  return true;
+}
+
+bool SurfaceVulkan::CreateSwapchain(uint32_t width, uint32_t height) {
+  VkSurfaceCapabilitiesKHR capabilities;
+  vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device_, surface_,
+                                            &capabilities);
+
+  uint32_t format_count = 0;
+  vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device_, surface_,
+                                       &format_count, nullptr);
+  std::vector<VkSurfaceFormatKHR> formats(format_count);
+  vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device_, surface_,
+                                       &format_count, formats.data());
+  if (formats.empty()) {
+    ELINUX_LOG(ERROR) << "The surface doesn't support any formats.";
+    return false;
+  }
+  surface_format_ = formats[0];
+  for (const auto& format : formats) {
+    if ((format.format == VK_FORMAT_B8G8R8A8_UNORM ||
+         format.format == VK_FORMAT_R8G8B8A8_UNORM) &&
+        format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+      surface_format_ = format;
+      break;
+    }
+  }
+
+  // Wayland surfaces don't have a size until a buffer is attached, so the
+  // swapchain decides it.
+  VkExtent2D extent = capabilities.currentExtent;
+  if (extent.width == UINT32_MAX) {
+    extent.width =
+        std::clamp(width, capabilities.minImageExtent.width,
+                   capabilities.maxImageExtent.width);
+    extent.height =
+        std::clamp(height, capabilities.minImageExtent.height,
+                   capabilities.maxImageExtent.height);
+  }
+
+  uint32_t image_count = capabilities.minImageCount + 1;
+  if (capabilities.maxImageCount > 0) {
+    image_count = std::min(image_count, capabilities.maxImageCount);
+  }
+
+#if defined(ENABLE_EGL_ALPHA_COMPONENT_OF_COLOR_BUFFER)
+  constexpr VkCompositeAlphaFlagBitsKHR kPreferredAlpha =
+      VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR;
+#else
+  constexpr VkCompositeAlphaFlagBitsKHR kPreferredAlpha =
+      VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+#endif
+  auto composite_alpha = kPreferredAlpha;
+  if (!(capabilities.supportedCompositeAlpha & kPreferredAlpha)) {
+    composite_alpha = VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR;
+  }
+
+  VkSwapchainCreateInfoKHR swapchain_info = {};
+  swapchain_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+  swapchain_info.surface = surface_;
+  swapchain_info.minImageCount = image_count;
+  swapchain_info.imageFormat = surface_format_.format;
+  swapchain_info.imageColorSpace = surface_format_.colorSpace;
+  swapchain_info.imageExtent = extent;
+  swapchain_info.imageArrayLayers = 1;
+  swapchain_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  swapchain_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  swapchain_info.preTransform = capabilities.currentTransform;
+  swapchain_info.compositeAlpha = composite_alpha;
+  swapchain_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+  swapchain_info.clipped = VK_TRUE;
+  swapchain_info.oldSwapchain = swapchain_;
+
+  VkSwapchainKHR swapchain;
+  auto result =
+      vkCreateSwapchainKHR(device_, &swapchain_info, nullptr, &swapchain);
+  DestroySwapchain();
+  if (result != VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to create the swapchain: " << result;
+    return false;
+  }
+  swapchain_ = swapchain;
+  swapchain_extent_ = extent;
+  swapchain_out_of_date_ = false;
+
+  uint32_t swapchain_image_count = 0;
+  vkGetSwapchainImagesKHR(device_, swapchain_, &swapchain_image_count,
+                          nullptr);
+  swapchain_images_.resize(swapchain_image_count);
+  vkGetSwapchainImagesKHR(device_, swapchain_, &swapchain_image_count,
+                          swapchain_images_.data());
+
+  present_transition_buffers_.resize(swapchain_image_count);
+  VkCommandBufferAllocateInfo buffers_info = {};
+  buffers_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  buffers_info.commandPool = command_pool_;
+  buffers_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  buffers_info.commandBufferCount = swapchain_image_count;
+  if (vkAllocateCommandBuffers(device_, &buffers_info,
+                               present_transition_buffers_.data()) !=
+      VK_SUCCESS) {
+    ELINUX_LOG(ERROR) << "Failed to allocate the command buffers.";
+    present_transition_buffers_.clear();
+    return false;
+  }
+
+  for (uint32_t i = 0; i < swapchain_image_count; i++) {
+    auto buffer = present_transition_buffers_[i];
+
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(buffer, &begin_info);
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = swapchain_images_[i];
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+
+    vkEndCommandBuffer(buffer);
+  }
+
+  VkSemaphoreCreateInfo semaphore_info = {};
+  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  for (uint32_t i = 0; i < swapchain_image_count; i++) {
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device_, &semaphore_info, nullptr, &semaphore) !=
+        VK_SUCCESS) {
+      ELINUX_LOG(ERROR) << "Failed to create the semaphores.";
+      return false;
+    }
+    present_ready_semaphores_.push_back(semaphore);
+  }
+
+  ELINUX_LOG(TRACE) << "Created the swapchain: " << extent.width << "x"
+                    << extent.height << ", " << swapchain_image_count
+                    << " images";
+  return true;
+}
+
+void SurfaceVulkan::DestroySwapchain() {
+  if (!present_transition_buffers_.empty()) {
+    vkFreeCommandBuffers(device_, command_pool_,
+                         present_transition_buffers_.size(),
+                         present_transition_buffers_.data());
+    present_transition_buffers_.clear();
+  }
+  for (auto semaphore : present_ready_semaphores_) {
+    vkDestroySemaphore(device_, semaphore, nullptr);
+  }
+  present_ready_semaphores_.clear();
+  swapchain_images_.clear();
+  if (swapchain_ != VK_NULL_HANDLE) {
+    vkDestroySwapchainKHR(device_, swapchain_, nullptr);
+    swapchain_ = VK_NULL_HANDLE;
+  }
+}
+
+}  // namespace flutter
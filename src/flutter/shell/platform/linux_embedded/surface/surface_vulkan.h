@@ -0,0 +1,94 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_SURFACE_VULKAN_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_SURFACE_VULKAN_H_
+
+#define VK_USE_PLATFORM_WAYLAND_KHR
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "flutter/shell/platform/embedder/embedder.h"
+#include "flutter/shell/platform/linux_embedded/window/native_window_wayland.h"
+
+namespace flutter {
+
+// A render surface which presents the frames rendered by the engine's Vulkan
+// backend with a VK_KHR_wayland_surface swapchain. Only the Wayland backend
+// has one: the DRM backends always render with OpenGL ES.
+class SurfaceVulkan {
+ public:
+  SurfaceVulkan(wl_display* display);
+  ~SurfaceVulkan();
+
+  // Prevent copying.
+  SurfaceVulkan(SurfaceVulkan const&) = delete;
+  SurfaceVulkan& operator=(SurfaceVulkan const&) = delete;
+
+  // Shows a surface is valid or not.
+  bool IsValid() const;
+
+  // Creates the device and the swapchain for the window's surface.
+  bool SetNativeWindow(NativeWindowWayland* window);
+
+  // Changes the window size. The swapchain follows the frame size requested by
+  // the engine, so it is recreated with the next frame.
+  bool OnScreenSurfaceResize(const size_t width, const size_t height);
+
+  // Fills the Vulkan handles and extensions of |config|.
+  void GetRendererConfig(FlutterVulkanRendererConfig* config) const;
+
+  void* GetInstanceProcAddress(VkInstance instance, const char* name) const;
+
+  // Acquires the next swapchain image. This blocks until the image can be
+  // rendered into, so the engine can use it immediately.
+  FlutterVulkanImage AcquireNextImage(size_t width, size_t height);
+
+  // Presents the image returned by the last AcquireNextImage().
+  bool Present(const FlutterVulkanImage* image);
+
+ private:
+  bool CreateInstance();
+
+  bool CreateDevice();
+
+  bool CreateSwapchain(uint32_t width, uint32_t height);
+
+  void DestroySwapchain();
+
+  wl_display* wl_display_;
+  NativeWindowWayland* native_window_ = nullptr;
+
+  VkInstance instance_ = VK_NULL_HANDLE;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
+  VkPhysicalDevice physical_device_ = VK_NULL_HANDLE;
+  VkDevice device_ = VK_NULL_HANDLE;
+  uint32_t queue_family_index_ = 0;
+  VkQueue queue_ = VK_NULL_HANDLE;
+  VkCommandPool command_pool_ = VK_NULL_HANDLE;
+  VkFence image_ready_fence_ = VK_NULL_HANDLE;
+  std::vector<const char*> instance_extensions_;
+  std::vector<const char*> device_extensions_;
+
+  VkSwapchainKHR swapchain_ = VK_NULL_HANDLE;
+  VkSurfaceFormatKHR surface_format_ = {};
+  VkExtent2D swapchain_extent_ = {};
+  std::vector<VkImage> swapchain_images_;
+  // Transitions each swapchain image from the layout the engine renders in to
+  // the one the presentation engine expects.
+  std::vector<VkCommandBuffer> present_transition_buffers_;
+  // Signaled by the transition of each swapchain image, and waited for by its
+  // presentation. One per image, so that a semaphore isn't signaled again
+  // while the presentation of another image may still wait for it.
+  std::vector<VkSemaphore> present_ready_semaphores_;
+  uint32_t last_image_index_ = 0;
+  bool swapchain_out_of_date_ = false;
+
+  bool valid_ = false;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SURFACE_SURFACE_VULKAN_H_
@@ -4,13 +4,44 @@
 
 #include "flutter/shell/platform/linux_embedded/system_utils.h"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
+#include <limits>
 #include <sstream>
 
 namespace flutter {
 
 namespace {
 
+constexpr char kCgroupFsRoot[] = "/sys/fs/cgroup";
+
+// Returns the path of this process's cgroup v2, e.g. "/system.slice/foo",
+// or an empty string on cgroup v1.
+std::string GetCgroupV2Path() {
+  std::ifstream file("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(file, line)) {
+    // The unified hierarchy is listed as "0::<path>".
+    if (line.rfind("0::", 0) == 0) {
+      return line.substr(3);
+    }
+  }
+  return "";
+}
+
+// Reads a cgroup memory limit file. Returns max if it's missing or "max".
+uint64_t ReadCgroupMemoryLimit(const std::string& path) {
+  std::ifstream file(path);
+  std::string value;
+  if (!(file >> value) || value == "max") {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return std::strtoull(value.c_str(), nullptr, 10);
+}
+
 const char* GetLocaleStringFromEnvironment() {
   const char* retval;
   retval = getenv("LANGUAGE");
@@ -151,4 +182,23 @@ std::vector<FlutterLocale> ConvertToFlutterLocale(
   return flutter_locales;
 }
 
+uint64_t GetProcessMemoryLimit() {
+  uint64_t limit = static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) *
+                   static_cast<uint64_t>(sysconf(_SC_PAGE_SIZE));
+
+  // The limits of the parent cgroups apply as well.
+  auto cgroup = GetCgroupV2Path();
+  while (!cgroup.empty()) {
+    auto dir = std::string(kCgroupFsRoot) + cgroup;
+    limit = std::min(limit, ReadCgroupMemoryLimit(dir + "/memory.max"));
+    limit = std::min(limit, ReadCgroupMemoryLimit(dir + "/memory.high"));
+    if (cgroup == "/") {
+      break;
+    }
+    auto pos = cgroup.find_last_of('/');
+    cgroup = pos == 0 ? "/" : cgroup.substr(0, pos);
+  }
+  return limit;
+}
+
 }  // namespace flutter
@@ -30,6 +30,11 @@ std::vector<LanguageInfo> GetPreferredLanguageInfo();
 std::vector<FlutterLocale> ConvertToFlutterLocale(
     const std::vector<LanguageInfo>& languages);
 
+// Returns the memory available to this process in bytes: the lowest cgroup v2
+// memory.max or memory.high on the path of its cgroup, or the physical memory
+// if there is no limit.
+uint64_t GetProcessMemoryLimit();
+
 }  // namespace flutter
 
 #endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_SYSTEM_UTILS_H_
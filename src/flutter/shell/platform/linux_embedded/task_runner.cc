@@ -4,10 +4,16 @@
 
 #include "flutter/shell/platform/linux_embedded/task_runner.h"
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #include <atomic>
 #include <iostream>
 #include <utility>
 
+#include "flutter/shell/platform/linux_embedded/allocation_tracker.h"
+#include "flutter/shell/platform/linux_embedded/logger.h"
+
 namespace flutter {
 
 TaskRunner::TaskRunner(std::thread::id main_thread_id,
@@ -15,7 +21,18 @@ TaskRunner::TaskRunner(std::thread::id main_thread_id,
                        const TaskExpiredCallback& on_task_expired)
     : main_thread_id_(main_thread_id),
       get_current_time_(get_current_time),
-      on_task_expired_(std::move(on_task_expired)) {}
+      on_task_expired_(std::move(on_task_expired)) {
+  wakeup_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wakeup_fd_ == -1) {
+    ELINUX_LOG(ERROR) << "Failed to create the task runner wakeup fd.";
+  }
+}
+
+TaskRunner::~TaskRunner() {
+  if (wakeup_fd_ != -1) {
+    close(wakeup_fd_);
+  }
+}
 
 bool TaskRunner::RunsTasksOnCurrentThread() const {
   return std::this_thread::get_id() == main_thread_id_;
@@ -23,6 +40,8 @@ bool TaskRunner::RunsTasksOnCurrentThread() const {
 
 void TaskRunner::PostFlutterTask(FlutterTask flutter_task,
                                  uint64_t flutter_target_time_nanos) {
+  ScopedAllocationRegion allocation_region(
+      kFlutterDesktopAllocationRegionTaskRunner);
   Task task;
   task.fire_time = TimePointFromFlutterTime(flutter_target_time_nanos);
   task.variant = flutter_task;
@@ -30,6 +49,8 @@ void TaskRunner::PostFlutterTask(FlutterTask flutter_task,
 }
 
 void TaskRunner::PostTask(TaskClosure closure) {
+  ScopedAllocationRegion allocation_region(
+      kFlutterDesktopAllocationRegionTaskRunner);
   Task task;
   task.fire_time = TaskTimePoint::clock::now();
   task.variant = std::move(closure);
@@ -41,13 +62,34 @@ void TaskRunner::EnqueueTask(Task task) {
 
   task.order = ++sGlobalTaskOrder;
 
-  std::lock_guard<std::mutex> lock(task_queue_mutex_);
-  task_queue_.push(task);
+  {
+    std::lock_guard<std::mutex> lock(task_queue_mutex_);
+    task_queue_.push(task);
+  }
+  WakeUp();
+}
+
+void TaskRunner::WakeUp() {
+  if (wakeup_fd_ != -1) {
+    uint64_t value = 1;
+    // Only fails with EAGAIN when the counter is saturated, which still leaves
+    // the fd readable.
+    [[maybe_unused]] auto result = write(wakeup_fd_, &value, sizeof(value));
+  }
 }
 
 std::chrono::nanoseconds TaskRunner::ProcessTasks() {
+  ScopedAllocationRegion allocation_region(
+      kFlutterDesktopAllocationRegionTaskRunner);
   const TaskTimePoint now = TaskTimePoint::clock::now();
 
+  // Clear the wakeup fd before looking at the queue, so that a task posted
+  // while processing signals it again.
+  if (wakeup_fd_ != -1) {
+    uint64_t value;
+    [[maybe_unused]] auto result = read(wakeup_fd_, &value, sizeof(value));
+  }
+
   std::vector<Task> expired_tasks;
 
   // Process expired tasks.
@@ -77,6 +119,8 @@ std::chrono::nanoseconds TaskRunner::ProcessTasks() {
     // Flushing tasks here without holing onto the task queue mutex.
     for (const auto& task : expired_tasks) {
       if (auto flutter_task = std::get_if<FlutterTask>(&task.variant)) {
+        // The engine's own work isn't accounted to the embedder.
+        ScopedAllocationRegion engine_task_region;
         on_task_expired_(flutter_task);
       } else if (auto closure = std::get_if<TaskClosure>(&task.variant))
         (*closure)();
@@ -94,6 +138,19 @@ std::chrono::nanoseconds TaskRunner::ProcessTasks() {
   }
 }
 
+std::chrono::nanoseconds TaskRunner::GetNextTimeout() {
+  std::lock_guard<std::mutex> lock(task_queue_mutex_);
+  if (task_queue_.empty()) {
+    return std::chrono::nanoseconds::max();
+  }
+  const auto now = TaskTimePoint::clock::now();
+  const auto next_wake = task_queue_.top().fire_time;
+  if (next_wake <= now) {
+    return std::chrono::nanoseconds::zero();
+  }
+  return std::min(next_wake - now, std::chrono::nanoseconds::max());
+}
+
 TaskRunner::TaskTimePoint TaskRunner::TimePointFromFlutterTime(
     uint64_t flutter_target_time_nanos) const {
   const auto now = TaskTimePoint::clock::now();
@@ -29,7 +29,7 @@ class TaskRunner {
   TaskRunner(std::thread::id main_thread_id,
              CurrentTimeProc get_current_time,
              const TaskExpiredCallback& on_task_expired);
-  ~TaskRunner() = default;
+  ~TaskRunner();
 
   // Returns if the current thread is the UI thread.
   bool RunsTasksOnCurrentThread() const;
@@ -54,6 +54,17 @@ class TaskRunner {
   // Process a Flutter engine tasks.
   std::chrono::nanoseconds ProcessTasks();
 
+  // Returns the duration until the earliest task expires, or
+  // std::chrono::nanoseconds::max() if none is queued.
+  std::chrono::nanoseconds GetNextTimeout();
+
+  // Returns an eventfd which becomes readable when a task is posted. It's
+  // cleared by ProcessTasks().
+  int GetWakeupFd() const { return wakeup_fd_; }
+
+  // Makes the wakeup fd readable without posting a task.
+  void WakeUp();
+
  private:
   typedef std::variant<FlutterTask, TaskClosure> TaskVariant;
 
@@ -84,6 +95,7 @@ class TaskRunner {
   TaskExpiredCallback on_task_expired_;
   std::mutex task_queue_mutex_;
   std::priority_queue<Task, std::deque<Task>, Task::Comparer> task_queue_;
+  int wakeup_fd_ = -1;
 };
 
 }  // namespace flutter
@@ -0,0 +1,282 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/texture_decoder.h"
+
+namespace flutter {
+
+namespace {
+
+constexpr uint32_t kEtc1Rgb8 = 0x8D64;  // GL_ETC1_RGB8_OES
+constexpr uint32_t kEtc2Rgb8 = 0x9274;  // GL_COMPRESSED_RGB8_ETC2
+constexpr uint32_t kBc1Rgb = 0x83F0;    // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+constexpr uint32_t kBc1Rgba = 0x83F1;   // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+
+// All the supported formats use 8 bytes per block of 4x4 pixels.
+constexpr size_t kBlockSize = 4;
+constexpr size_t kBlockBytes = 8;
+
+// Intensity modifiers of the ETC1 and ETC2 individual and differential modes,
+// indexed by the table codeword and the pixel index.
+constexpr int kEtcModifiers[8][4] = {
+    {2, 8, -2, -8},     {5, 17, -5, -17},   {9, 29, -9, -29},
+    {13, 42, -13, -42}, {18, 60, -18, -60}, {24, 80, -24, -80},
+    {33, 106, -33, -106}, {47, 183, -47, -183},
+};
+
+// Distances of the ETC2 T and H modes.
+constexpr int kEtcDistances[8] = {3, 6, 11, 16, 20, 23, 27, 32};
+
+struct Color {
+  int r;
+  int g;
+  int b;
+};
+
+// RGBA pixels of a block, row by row.
+using Block = uint8_t[kBlockSize * kBlockSize][4];
+
+int Bits(uint64_t block, int high, int count) {
+  return static_cast<int>((block >> (high - count + 1)) & ((1u << count) - 1));
+}
+
+uint8_t Clamp(int value) {
+  return value < 0 ? 0 : value > 255 ? 255 : static_cast<uint8_t>(value);
+}
+
+int Extend4(int c) {
+  return (c << 4) | c;
+}
+
+int Extend5(int c) {
+  return (c << 3) | (c >> 2);
+}
+
+int Extend6(int c) {
+  return (c << 2) | (c >> 4);
+}
+
+int Extend7(int c) {
+  return (c << 1) | (c >> 6);
+}
+
+Color Offset(const Color& color, int offset) {
+  return {color.r + offset, color.g + offset, color.b + offset};
+}
+
+void SetPixel(Block& block, int x, int y, const Color& color) {
+  auto* pixel = block[y * kBlockSize + x];
+  pixel[0] = Clamp(color.r);
+  pixel[1] = Clamp(color.g);
+  pixel[2] = Clamp(color.b);
+  pixel[3] = 255;
+}
+
+// Returns the 2-bit index of pixel (|x|, |y|) of an ETC block. The pixels are
+// numbered column by column, with the most significant bits in bits 31..16.
+int EtcPixelIndex(uint64_t block, int x, int y) {
+  int i = x * kBlockSize + y;
+  return (((block >> (16 + i)) & 1) << 1) | ((block >> i) & 1);
+}
+
+void DecodeEtcPaintColors(uint64_t block, const Color paint[4], Block& out) {
+  for (int y = 0; y < static_cast<int>(kBlockSize); y++) {
+    for (int x = 0; x < static_cast<int>(kBlockSize); x++) {
+      SetPixel(out, x, y, paint[EtcPixelIndex(block, x, y)]);
+    }
+  }
+}
+
+void DecodeEtc2TMode(uint64_t block, Block& out) {
+  Color c1 = {Extend4((Bits(block, 60, 2) << 2) | Bits(block, 57, 2)),
+              Extend4(Bits(block, 55, 4)), Extend4(Bits(block, 51, 4))};
+  Color c2 = {Extend4(Bits(block, 47, 4)), Extend4(Bits(block, 43, 4)),
+              Extend4(Bits(block, 39, 4))};
+  int d = kEtcDistances[(Bits(block, 35, 2) << 1) | Bits(block, 32, 1)];
+  Color paint[4] = {c1, Offset(c2, d), c2, Offset(c2, -d)};
+  DecodeEtcPaintColors(block, paint, out);
+}
+
+void DecodeEtc2HMode(uint64_t block, Block& out) {
+  int r1 = Bits(block, 62, 4);
+  int g1 = (Bits(block, 58, 3) << 1) | Bits(block, 52, 1);
+  int b1 = (Bits(block, 51, 1) << 3) | Bits(block, 49, 3);
+  int r2 = Bits(block, 46, 4);
+  int g2 = Bits(block, 42, 4);
+  int b2 = Bits(block, 38, 4);
+  // The order of the base colors encodes the lowest bit of the distance.
+  int order = ((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2);
+  int d = kEtcDistances[(Bits(block, 34, 1) << 2) | (Bits(block, 32, 1) << 1) |
+                        order];
+  Color c1 = {Extend4(r1), Extend4(g1), Extend4(b1)};
+  Color c2 = {Extend4(r2), Extend4(g2), Extend4(b2)};
+  Color paint[4] = {Offset(c1, d), Offset(c1, -d), Offset(c2, d),
+                    Offset(c2, -d)};
+  DecodeEtcPaintColors(block, paint, out);
+}
+
+void DecodeEtc2PlanarMode(uint64_t block, Block& out) {
+  Color o = {Extend6(Bits(block, 62, 6)),
+             Extend7((Bits(block, 56, 1) << 6) | Bits(block, 54, 6)),
+             Extend6((Bits(block, 48, 1) << 5) | (Bits(block, 44, 2) << 3) |
+                     Bits(block, 41, 3))};
+  Color h = {Extend6((Bits(block, 38, 5) << 1) | Bits(block, 32, 1)),
+             Extend7(Bits(block, 31, 7)), Extend6(Bits(block, 24, 6))};
+  Color v = {Extend6(Bits(block, 18, 6)), Extend7(Bits(block, 12, 7)),
+             Extend6(Bits(block, 5, 6))};
+  for (int y = 0; y < static_cast<int>(kBlockSize); y++) {
+    for (int x = 0; x < static_cast<int>(kBlockSize); x++) {
+      Color color = {
+          (x * (h.r - o.r) + y * (v.r - o.r) + 4 * o.r + 2) >> 2,
+          (x * (h.g - o.g) + y * (v.g - o.g) + 4 * o.g + 2) >> 2,
+          (x * (h.b - o.b) + y * (v.b - o.b) + 4 * o.b + 2) >> 2,
+      };
+      SetPixel(out, x, y, color);
+    }
+  }
+}
+
+// Decodes an ETC2 RGB8 block. ETC1 blocks are valid ETC2 blocks which never
+// use the T, H and planar modes.
+void DecodeEtc2Block(const uint8_t* data, Block& out) {
+  uint64_t block = 0;
+  for (size_t i = 0; i < kBlockBytes; i++) {
+    block = (block << 8) | data[i];
+  }
+
+  Color base[2];
+  if (Bits(block, 33, 1) == 0) {
+    // Individual mode.
+    base[0] = {Extend4(Bits(block, 63, 4)), Extend4(Bits(block, 55, 4)),
+               Extend4(Bits(block, 47, 4))};
+    base[1] = {Extend4(Bits(block, 59, 4)), Extend4(Bits(block, 51, 4)),
+               Extend4(Bits(block, 43, 4))};
+  } else {
+    // Differential mode, unless a second base color overflows.
+    auto delta = [block](int high) {
+      int value = Bits(block, high, 3);
+      return value >= 4 ? value - 8 : value;
+    };
+    int r = Bits(block, 63, 5);
+    int g = Bits(block, 55, 5);
+    int b = Bits(block, 47, 5);
+    int r2 = r + delta(58);
+    int g2 = g + delta(50);
+    int b2 = b + delta(42);
+    if (r2 < 0 || r2 > 31) {
+      DecodeEtc2TMode(block, out);
+      return;
+    } else if (g2 < 0 || g2 > 31) {
+      DecodeEtc2HMode(block, out);
+      return;
+    } else if (b2 < 0 || b2 > 31) {
+      DecodeEtc2PlanarMode(block, out);
+      return;
+    }
+    base[0] = {Extend5(r), Extend5(g), Extend5(b)};
+    base[1] = {Extend5(r2), Extend5(g2), Extend5(b2)};
+  }
+
+  // The block is split into two 2x4 halves, or two 4x2 halves if flipped.
+  int tables[2] = {Bits(block, 39, 3), Bits(block, 36, 3)};
+  bool flip = Bits(block, 32, 1);
+  for (int y = 0; y < static_cast<int>(kBlockSize); y++) {
+    for (int x = 0; x < static_cast<int>(kBlockSize); x++) {
+      int half = flip ? y / 2 : x / 2;
+      int modifier = kEtcModifiers[tables[half]][EtcPixelIndex(block, x, y)];
+      SetPixel(out, x, y, Offset(base[half], modifier));
+    }
+  }
+}
+
+Color Rgb565(uint16_t value) {
+  return {Extend5(value >> 11), Extend6((value >> 5) & 0x3F),
+          Extend5(value & 0x1F)};
+}
+
+// Decodes a BC1 block. Without |alpha|, the transparent color is opaque black.
+void DecodeBc1Block(const uint8_t* data, bool alpha, Block& out) {
+  uint16_t value0 = data[0] | (data[1] << 8);
+  uint16_t value1 = data[2] | (data[3] << 8);
+  uint32_t indices =
+      data[4] | (data[5] << 8) | (data[6] << 16) | (uint32_t{data[7]} << 24);
+
+  Color c0 = Rgb565(value0);
+  Color c1 = Rgb565(value1);
+  Color palette[4] = {c0, c1};
+  bool transparent = false;
+  if (value0 > value1) {
+    palette[2] = {(2 * c0.r + c1.r) / 3, (2 * c0.g + c1.g) / 3,
+                  (2 * c0.b + c1.b) / 3};
+    palette[3] = {(c0.r + 2 * c1.r) / 3, (c0.g + 2 * c1.g) / 3,
+                  (c0.b + 2 * c1.b) / 3};
+  } else {
+    palette[2] = {(c0.r + c1.r) / 2, (c0.g + c1.g) / 2, (c0.b + c1.b) / 2};
+    palette[3] = {0, 0, 0};
+    transparent = alpha;
+  }
+
+  for (int y = 0; y < static_cast<int>(kBlockSize); y++) {
+    for (int x = 0; x < static_cast<int>(kBlockSize); x++) {
+      int index = (indices >> (2 * (y * kBlockSize + x))) & 3;
+      SetPixel(out, x, y, palette[index]);
+      if (transparent && index == 3) {
+        // Premultiplied, like the engine samples it.
+        out[y * kBlockSize + x][3] = 0;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+bool CanDecodeCompressedTexture(uint32_t format) {
+  return format == kEtc1Rgb8 || format == kEtc2Rgb8 || format == kBc1Rgb ||
+         format == kBc1Rgba;
+}
+
+bool DecodeCompressedTexture(uint32_t format,
+                             const uint8_t* data,
+                             size_t data_size,
+                             size_t width,
+                             size_t height,
+                             std::vector<uint8_t>* pixels) {
+  if (!CanDecodeCompressedTexture(format)) {
+    return false;
+  }
+  size_t blocks_x = (width + kBlockSize - 1) / kBlockSize;
+  size_t blocks_y = (height + kBlockSize - 1) / kBlockSize;
+  if (data_size < blocks_x * blocks_y * kBlockBytes) {
+    return false;
+  }
+
+  pixels->resize(width * height * 4);
+  Block block;
+  for (size_t by = 0; by < blocks_y; by++) {
+    for (size_t bx = 0; bx < blocks_x; bx++) {
+      const uint8_t* block_data = data + (by * blocks_x + bx) * kBlockBytes;
+      if (format == kBc1Rgb || format == kBc1Rgba) {
+        DecodeBc1Block(block_data, format == kBc1Rgba, block);
+      } else {
+        DecodeEtc2Block(block_data, block);
+      }
+
+      // Blocks at the right and bottom edges may extend past the image.
+      for (size_t y = 0; y < kBlockSize && by * kBlockSize + y < height; y++) {
+        for (size_t x = 0; x < kBlockSize && bx * kBlockSize + x < width;
+             x++) {
+          uint8_t* pixel = pixels->data() +
+                           ((by * kBlockSize + y) * width + bx * kBlockSize +
+                            x) * 4;
+          for (int c = 0; c < 4; c++) {
+            pixel[c] = block[y * kBlockSize + x][c];
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace flutter
@@ -0,0 +1,33 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_DECODER_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace flutter {
+
+// Software decoders of block compressed textures, for GPUs which can't sample
+// the format. ETC1 and ETC2 RGB8 (including the T, H and planar modes) and
+// BC1 (DXT1) are supported.
+
+// Returns true if DecodeCompressedTexture supports the GL internal |format|.
+bool CanDecodeCompressedTexture(uint32_t format);
+
+// Decodes |data| of |width| x |height| pixels in the GL internal |format| to
+// RGBA8888 in |pixels|. Returns false if the format isn't supported or
+// |data_size| is smaller than the blocks which cover the image.
+bool DecodeCompressedTexture(uint32_t format,
+                             const uint8_t* data,
+                             size_t data_size,
+                             size_t width,
+                             size_t height,
+                             std::vector<uint8_t>* pixels);
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_DECODER_H_
@@ -0,0 +1,360 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/texture_downscaler.h"
+
+#include <EGL/egl.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "flutter/shell/platform/linux_embedded/logger.h"
+
+namespace flutter {
+
+namespace {
+
+// The vertex array object binding is only in GLES 3.
+constexpr GLenum kGlVertexArrayBinding = 0x85B5;
+typedef void (*glBindVertexArrayProc)(GLuint array);
+
+// Number of bilinear taps per axis. Each tap averages 2x2 texels.
+constexpr int kTaps = 4;
+
+constexpr char kVertexShader[] = R"(
+attribute vec2 position;
+varying vec2 coord;
+void main() {
+  coord = position * 0.5 + 0.5;
+  gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+// |texel_step| is the distance between the taps, which spread over the
+// source texels covered by one target pixel.
+// Texture coordinates need more than the 10 bits of mediump to address the
+// texels of large sources, so highp is used where fragment shaders have it.
+constexpr char kFragmentShader[] = R"(
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+uniform sampler2D source;
+uniform vec2 texel_step;
+varying vec2 coord;
+void main() {
+  vec4 sum = vec4(0.0);
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      vec2 offset = (vec2(float(x), float(y)) - 1.5) * texel_step;
+      sum += texture2D(source, coord + offset);
+    }
+  }
+  gl_FragColor = sum / 16.0;
+}
+)";
+
+struct GlDownscaleProcs {
+  PFNGLCREATESHADERPROC glCreateShader;
+  PFNGLSHADERSOURCEPROC glShaderSource;
+  PFNGLCOMPILESHADERPROC glCompileShader;
+  PFNGLGETSHADERIVPROC glGetShaderiv;
+  PFNGLDELETESHADERPROC glDeleteShader;
+  PFNGLCREATEPROGRAMPROC glCreateProgram;
+  PFNGLATTACHSHADERPROC glAttachShader;
+  PFNGLLINKPROGRAMPROC glLinkProgram;
+  PFNGLGETPROGRAMIVPROC glGetProgramiv;
+  PFNGLDELETEPROGRAMPROC glDeleteProgram;
+  PFNGLGETATTRIBLOCATIONPROC glGetAttribLocation;
+  PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
+  PFNGLUSEPROGRAMPROC glUseProgram;
+  PFNGLUNIFORM1IPROC glUniform1i;
+  PFNGLUNIFORM2FPROC glUniform2f;
+  PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
+  PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
+  PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer;
+  PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D;
+  PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus;
+  PFNGLGETINTEGERVPROC glGetIntegerv;
+  PFNGLISENABLEDPROC glIsEnabled;
+  PFNGLENABLEPROC glEnable;
+  PFNGLDISABLEPROC glDisable;
+  PFNGLVIEWPORTPROC glViewport;
+  PFNGLACTIVETEXTUREPROC glActiveTexture;
+  PFNGLBINDTEXTUREPROC glBindTexture;
+  PFNGLTEXPARAMETERIPROC glTexParameteri;
+  PFNGLBINDBUFFERPROC glBindBuffer;
+  PFNGLGETVERTEXATTRIBIVPROC glGetVertexAttribiv;
+  PFNGLGETVERTEXATTRIBPOINTERVPROC glGetVertexAttribPointerv;
+  PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer;
+  PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
+  PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray;
+  PFNGLDRAWARRAYSPROC glDrawArrays;
+  glBindVertexArrayProc glBindVertexArray;
+  bool valid;
+};
+
+template <typename T>
+void Resolve(T& proc, const char* name) {
+  proc = reinterpret_cast<T>(eglGetProcAddress(name));
+}
+
+const GlDownscaleProcs& GetGlProcs() {
+  static const GlDownscaleProcs procs = []() {
+    GlDownscaleProcs p = {};
+    Resolve(p.glCreateShader, "glCreateShader");
+    Resolve(p.glShaderSource, "glShaderSource");
+    Resolve(p.glCompileShader, "glCompileShader");
+    Resolve(p.glGetShaderiv, "glGetShaderiv");
+    Resolve(p.glDeleteShader, "glDeleteShader");
+    Resolve(p.glCreateProgram, "glCreateProgram");
+    Resolve(p.glAttachShader, "glAttachShader");
+    Resolve(p.glLinkProgram, "glLinkProgram");
+    Resolve(p.glGetProgramiv, "glGetProgramiv");
+    Resolve(p.glDeleteProgram, "glDeleteProgram");
+    Resolve(p.glGetAttribLocation, "glGetAttribLocation");
+    Resolve(p.glGetUniformLocation, "glGetUniformLocation");
+    Resolve(p.glUseProgram, "glUseProgram");
+    Resolve(p.glUniform1i, "glUniform1i");
+    Resolve(p.glUniform2f, "glUniform2f");
+    Resolve(p.glGenFramebuffers, "glGenFramebuffers");
+    Resolve(p.glDeleteFramebuffers, "glDeleteFramebuffers");
+    Resolve(p.glBindFramebuffer, "glBindFramebuffer");
+    Resolve(p.glFramebufferTexture2D, "glFramebufferTexture2D");
+    Resolve(p.glCheckFramebufferStatus, "glCheckFramebufferStatus");
+    Resolve(p.glGetIntegerv, "glGetIntegerv");
+    Resolve(p.glIsEnabled, "glIsEnabled");
+    Resolve(p.glEnable, "glEnable");
+    Resolve(p.glDisable, "glDisable");
+    Resolve(p.glViewport, "glViewport");
+    Resolve(p.glActiveTexture, "glActiveTexture");
+    Resolve(p.glBindTexture, "glBindTexture");
+    Resolve(p.glTexParameteri, "glTexParameteri");
+    Resolve(p.glBindBuffer, "glBindBuffer");
+    Resolve(p.glGetVertexAttribiv, "glGetVertexAttribiv");
+    Resolve(p.glGetVertexAttribPointerv, "glGetVertexAttribPointerv");
+    Resolve(p.glVertexAttribPointer, "glVertexAttribPointer");
+    Resolve(p.glEnableVertexAttribArray, "glEnableVertexAttribArray");
+    Resolve(p.glDisableVertexAttribArray, "glDisableVertexAttribArray");
+    Resolve(p.glDrawArrays, "glDrawArrays");
+    // Optional.
+    Resolve(p.glBindVertexArray, "glBindVertexArray");
+
+    p.valid = p.glCreateShader && p.glShaderSource && p.glCompileShader &&
+              p.glGetShaderiv && p.glDeleteShader && p.glCreateProgram &&
+              p.glAttachShader && p.glLinkProgram && p.glGetProgramiv &&
+              p.glDeleteProgram && p.glGetAttribLocation &&
+              p.glGetUniformLocation && p.glUseProgram && p.glUniform1i &&
+              p.glUniform2f && p.glGenFramebuffers && p.glDeleteFramebuffers &&
+              p.glBindFramebuffer && p.glFramebufferTexture2D &&
+              p.glCheckFramebufferStatus && p.glGetIntegerv && p.glIsEnabled &&
+              p.glEnable && p.glDisable && p.glViewport &&
+              p.glActiveTexture && p.glBindTexture && p.glTexParameteri &&
+              p.glBindBuffer && p.glGetVertexAttribiv &&
+              p.glGetVertexAttribPointerv && p.glVertexAttribPointer &&
+              p.glEnableVertexAttribArray && p.glDisableVertexAttribArray &&
+              p.glDrawArrays;
+    return p;
+  }();
+  return procs;
+}
+
+GLuint CompileShader(const GlDownscaleProcs& gl,
+                     GLenum type,
+                     const char* source) {
+  auto shader = gl.glCreateShader(type);
+  gl.glShaderSource(shader, 1, &source, nullptr);
+  gl.glCompileShader(shader);
+  GLint compiled = GL_FALSE;
+  gl.glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+  if (compiled != GL_TRUE) {
+    gl.glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+// Returns the distance between the taps along an axis, in texture coordinates.
+// The taps spread over the source texels covered by one target pixel, but no
+// less than a texel apart. They all sample the same point if the axis isn't
+// downscaled, which copies it exactly.
+float TexelStep(size_t source_size, size_t target_size) {
+  if (source_size <= target_size) {
+    return 0.0f;
+  }
+  return std::max(1.0f, static_cast<float>(source_size) / target_size /
+                            kTaps * 2) /
+         source_size;
+}
+
+// The capabilities which would affect the draw.
+constexpr GLenum kCapabilities[] = {GL_BLEND, GL_SCISSOR_TEST, GL_DEPTH_TEST,
+                                    GL_STENCIL_TEST, GL_CULL_FACE};
+
+}  // namespace
+
+TextureDownscaler::TextureDownscaler() = default;
+
+TextureDownscaler::~TextureDownscaler() {
+  if (eglGetCurrentContext() == EGL_NO_CONTEXT) {
+    return;
+  }
+  const auto& gl = GetGlProcs();
+  if (program_) {
+    gl.glDeleteProgram(program_);
+  }
+  if (framebuffer_) {
+    gl.glDeleteFramebuffers(1, &framebuffer_);
+  }
+}
+
+bool TextureDownscaler::Initialize() {
+  initialized_ = true;
+  const auto& gl = GetGlProcs();
+  if (!gl.valid) {
+    ELINUX_LOG(ERROR) << "Failed to resolve the GL functions to downscale "
+                         "textures.";
+    return false;
+  }
+
+  auto vertex_shader = CompileShader(gl, GL_VERTEX_SHADER, kVertexShader);
+  auto fragment_shader =
+      CompileShader(gl, GL_FRAGMENT_SHADER, kFragmentShader);
+  if (!vertex_shader || !fragment_shader) {
+    ELINUX_LOG(ERROR) << "Failed to compile the texture downscaling shaders.";
+    if (vertex_shader) {
+      gl.glDeleteShader(vertex_shader);
+    }
+    if (fragment_shader) {
+      gl.glDeleteShader(fragment_shader);
+    }
+    return false;
+  }
+
+  program_ = gl.glCreateProgram();
+  gl.glAttachShader(program_, vertex_shader);
+  gl.glAttachShader(program_, fragment_shader);
+  gl.glLinkProgram(program_);
+  gl.glDeleteShader(vertex_shader);
+  gl.glDeleteShader(fragment_shader);
+  GLint linked = GL_FALSE;
+  gl.glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    ELINUX_LOG(ERROR) << "Failed to link the texture downscaling program.";
+    gl.glDeleteProgram(program_);
+    program_ = 0;
+    return false;
+  }
+  position_location_ = gl.glGetAttribLocation(program_, "position");
+  texture_location_ = gl.glGetUniformLocation(program_, "source");
+  texel_step_location_ = gl.glGetUniformLocation(program_, "texel_step");
+
+  gl.glGenFramebuffers(1, &framebuffer_);
+  valid_ = true;
+  return true;
+}
+
+bool TextureDownscaler::Downscale(GLuint source,
+                                  size_t source_width,
+                                  size_t source_height,
+                                  GLuint target,
+                                  size_t target_width,
+                                  size_t target_height) {
+  if (!initialized_) {
+    Initialize();
+  }
+  if (!valid_) {
+    return false;
+  }
+  const auto& gl = GetGlProcs();
+
+  // Save the engine's state, which is tracked by its renderer.
+  GLint framebuffer, program, viewport[4], active_texture, texture_binding,
+      array_buffer, vertex_array = 0;
+  gl.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+  gl.glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+  gl.glGetIntegerv(GL_VIEWPORT, viewport);
+  gl.glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+  gl.glActiveTexture(GL_TEXTURE0);
+  gl.glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture_binding);
+  gl.glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_buffer);
+  if (gl.glBindVertexArray) {
+    gl.glGetIntegerv(kGlVertexArrayBinding, &vertex_array);
+    gl.glBindVertexArray(0);
+  }
+  GLboolean capabilities[std::size(kCapabilities)];
+  for (size_t i = 0; i < std::size(kCapabilities); i++) {
+    capabilities[i] = gl.glIsEnabled(kCapabilities[i]);
+    gl.glDisable(kCapabilities[i]);
+  }
+  GLint attrib_enabled, attrib_size, attrib_type, attrib_normalized,
+      attrib_stride, attrib_buffer;
+  void* attrib_pointer = nullptr;
+  gl.glGetVertexAttribiv(position_location_, GL_VERTEX_ATTRIB_ARRAY_ENABLED,
+                         &attrib_enabled);
+  gl.glGetVertexAttribiv(position_location_, GL_VERTEX_ATTRIB_ARRAY_SIZE,
+                         &attrib_size);
+  gl.glGetVertexAttribiv(position_location_, GL_VERTEX_ATTRIB_ARRAY_TYPE,
+                         &attrib_type);
+  gl.glGetVertexAttribiv(position_location_,
+                         GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &attrib_normalized);
+  gl.glGetVertexAttribiv(position_location_, GL_VERTEX_ATTRIB_ARRAY_STRIDE,
+                         &attrib_stride);
+  gl.glGetVertexAttribiv(position_location_,
+                         GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &attrib_buffer);
+  gl.glGetVertexAttribPointerv(position_location_,
+                               GL_VERTEX_ATTRIB_ARRAY_POINTER, &attrib_pointer);
+
+  gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  gl.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_TEXTURE_2D, target, 0);
+  auto complete = gl.glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+                  GL_FRAMEBUFFER_COMPLETE;
+  if (complete) {
+    static const GLfloat kQuad[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+    gl.glViewport(0, 0, target_width, target_height);
+    gl.glUseProgram(program_);
+    gl.glBindTexture(GL_TEXTURE_2D, source);
+    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl.glUniform1i(texture_location_, 0);
+    gl.glUniform2f(texel_step_location_,
+                   TexelStep(source_width, target_width),
+                   TexelStep(source_height, target_height));
+    gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+    gl.glVertexAttribPointer(position_location_, 2, GL_FLOAT, GL_FALSE, 0,
+                             kQuad);
+    gl.glEnableVertexAttribArray(position_location_);
+    gl.glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  } else {
+    ELINUX_LOG(ERROR) << "The downscaled texture can't be rendered to.";
+  }
+  gl.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_TEXTURE_2D, 0, 0);
+
+  // Restore the engine's state.
+  gl.glBindBuffer(GL_ARRAY_BUFFER, attrib_buffer);
+  gl.glVertexAttribPointer(position_location_, attrib_size, attrib_type,
+                           attrib_normalized, attrib_stride, attrib_pointer);
+  if (!attrib_enabled) {
+    gl.glDisableVertexAttribArray(position_location_);
+  }
+  gl.glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+  for (size_t i = 0; i < std::size(kCapabilities); i++) {
+    if (capabilities[i]) {
+      gl.glEnable(kCapabilities[i]);
+    }
+  }
+  if (gl.glBindVertexArray) {
+    gl.glBindVertexArray(vertex_array);
+  }
+  gl.glBindTexture(GL_TEXTURE_2D, texture_binding);
+  gl.glActiveTexture(active_texture);
+  gl.glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  gl.glUseProgram(program);
+  gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  return complete;
+}
+
+}  // namespace flutter
@@ -0,0 +1,57 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_DOWNSCALER_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_DOWNSCALER_H_
+
+#include <cstddef>
+
+#include "flutter/shell/platform/linux_embedded/external_texture.h"
+
+namespace flutter {
+
+// Renders a texture into a smaller one on the GPU, so that the engine samples
+// a texture of the displayed size instead of the source resolution.
+//
+// A box filter of up to 4x4 bilinear taps averages the source texels which
+// fall into each target pixel, so downscaling by up to 8x doesn't alias. An
+// axis which isn't downscaled is copied as is.
+//
+// Must only be used on the raster thread: the framebuffer isn't shared with
+// other contexts. The GL state changed by Downscale() is restored.
+class TextureDownscaler {
+ public:
+  TextureDownscaler();
+  ~TextureDownscaler();
+
+  // Prevent copying.
+  TextureDownscaler(TextureDownscaler const&) = delete;
+  TextureDownscaler& operator=(TextureDownscaler const&) = delete;
+
+  // Draws |source| (|source_width| x |source_height|) scaled into |target|,
+  // whose storage must be |target_width| x |target_height|.
+  // Returns false if the GL objects couldn't be created.
+  bool Downscale(GLuint source,
+                 size_t source_width,
+                 size_t source_height,
+                 GLuint target,
+                 size_t target_width,
+                 size_t target_height);
+
+ private:
+  // Creates the program and the framebuffer on first use.
+  bool Initialize();
+
+  bool initialized_ = false;
+  bool valid_ = false;
+  GLuint program_ = 0;
+  GLuint framebuffer_ = 0;
+  GLint position_location_ = -1;
+  GLint texture_location_ = -1;
+  GLint texel_step_location_ = -1;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_DOWNSCALER_H_
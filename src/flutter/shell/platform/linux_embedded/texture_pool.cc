@@ -0,0 +1,108 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/texture_pool.h"
+
+#include <EGL/egl.h>
+
+namespace flutter {
+
+namespace {
+// Limits of the pooled textures. A list of thumbnails typically cycles
+// through a few sizes, so a small pool is enough to avoid most allocations.
+constexpr size_t kMaxPooledTextures = 16;
+constexpr uint64_t kMaxPooledBytes = 32 * 1024 * 1024;
+
+constexpr uint64_t kBytesPerPixel = 4;
+
+uint64_t BucketKey(size_t width, size_t height) {
+  return (static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height);
+}
+
+uint64_t StorageBytes(uint64_t key) {
+  return (key >> 32) * (key & 0xffffffff) * kBytesPerPixel;
+}
+}  // namespace
+
+TexturePool::TexturePool(const GlProcs& gl_procs) : gl_(gl_procs) {}
+
+TexturePool::~TexturePool() {
+  // Without a current context, the textures are freed with the share group.
+  if (eglGetCurrentContext() == EGL_NO_CONTEXT) {
+    return;
+  }
+  for (auto& bucket : buckets_) {
+    for (auto& entry : bucket.second) {
+      gl_.glDeleteTextures(1, &entry.texture);
+    }
+  }
+}
+
+GLuint TexturePool::Acquire(size_t width, size_t height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto key = BucketKey(width, height);
+  auto bucket = buckets_.find(key);
+  if (bucket == buckets_.end() || bucket->second.empty()) {
+    misses_++;
+    return 0;
+  }
+
+  // The most recently released texture is the most likely to be resident.
+  auto texture = bucket->second.back().texture;
+  bucket->second.pop_back();
+  if (bucket->second.empty()) {
+    buckets_.erase(bucket);
+  }
+  count_--;
+  bytes_ -= StorageBytes(key);
+  hits_++;
+  return texture;
+}
+
+void TexturePool::Release(GLuint texture, size_t width, size_t height) {
+  auto key = BucketKey(width, height);
+  if (StorageBytes(key) > kMaxPooledBytes) {
+    gl_.glDeleteTextures(1, &texture);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  buckets_[key].push_back({texture, sequence_++});
+  count_++;
+  bytes_ += StorageBytes(key);
+  Trim();
+}
+
+void TexturePool::GetStats(FlutterDesktopEngineStats* stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats->texture_pool_count = count_;
+  stats->texture_pool_bytes = bytes_;
+  stats->texture_pool_max_count = kMaxPooledTextures;
+  stats->texture_pool_max_bytes = kMaxPooledBytes;
+  stats->texture_pool_hits = hits_;
+  stats->texture_pool_misses = misses_;
+}
+
+void TexturePool::Trim() {
+  while (count_ > kMaxPooledTextures || bytes_ > kMaxPooledBytes) {
+    // The oldest entry of each bucket is its first one.
+    auto oldest = buckets_.begin();
+    for (auto it = buckets_.begin(); it != buckets_.end(); ++it) {
+      if (it->second.front().sequence < oldest->second.front().sequence) {
+        oldest = it;
+      }
+    }
+
+    auto& entries = oldest->second;
+    gl_.glDeleteTextures(1, &entries.front().texture);
+    entries.erase(entries.begin());
+    count_--;
+    bytes_ -= StorageBytes(oldest->first);
+    if (entries.empty()) {
+      buckets_.erase(oldest);
+    }
+  }
+}
+
+}  // namespace flutter
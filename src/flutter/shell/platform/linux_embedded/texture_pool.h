@@ -0,0 +1,71 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_POOL_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/shell/platform/linux_embedded/external_texture.h"
+#include "flutter/shell/platform/linux_embedded/public/flutter_elinux.h"
+
+namespace flutter {
+
+// Keeps the GL textures of unregistered pixel buffer textures, so that a new
+// texture of the same size reuses their storage instead of allocating it
+// again. The textures are bucketed by their size, and the least recently
+// released ones are deleted when the pool exceeds its limits.
+//
+// All GL calls are made on the calling thread, which must have a context of
+// the engine's share group current (i.e. the raster thread).
+// Thread safety: All member methods are thread safe.
+class TexturePool {
+ public:
+  explicit TexturePool(const GlProcs& gl_procs);
+  ~TexturePool();
+
+  // Prevent copying.
+  TexturePool(TexturePool const&) = delete;
+  TexturePool& operator=(TexturePool const&) = delete;
+
+  // Returns a pooled texture with RGBA storage of |width| x |height|, or 0 if
+  // there is none, in which case the caller allocates a new one.
+  GLuint Acquire(size_t width, size_t height);
+
+  // Returns |texture|, whose storage is |width| x |height|, to the pool. The
+  // texture is deleted if it can't be kept.
+  void Release(GLuint texture, size_t width, size_t height);
+
+  // Fills the texture pool fields of |stats|.
+  void GetStats(FlutterDesktopEngineStats* stats);
+
+ private:
+  struct Entry {
+    GLuint texture;
+    // Order of the release, to evict the oldest entry first.
+    uint64_t sequence;
+  };
+
+  // Deletes the oldest entries until the pool fits in its limits.
+  void Trim();
+
+  const GlProcs& gl_;
+
+  std::mutex mutex_;
+  // Pooled textures keyed by their size.
+  std::unordered_map<uint64_t, std::vector<Entry>> buckets_;
+  size_t count_ = 0;
+  uint64_t bytes_ = 0;
+  uint64_t sequence_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_TEXTURE_POOL_H_
@@ -14,6 +14,7 @@
 #include <chrono>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "flutter/shell/platform/linux_embedded/logger.h"
 #include "flutter/shell/platform/linux_embedded/surface/surface_gl.h"
@@ -26,6 +27,11 @@ namespace flutter {
 namespace {
 constexpr char kFlutterDrmDeviceEnvironmentKey[] = "FLUTTER_DRM_DEVICE";
 constexpr char kDrmDeviceDefaultFilename[] = "/dev/dri/card0";
+
+// Seconds without any user input after which the display is turned off.
+// The display is never turned off if this isn't set or is zero.
+constexpr char kFlutterDrmIdleTimeoutEnvironmentKey[] =
+    "FLUTTER_DRM_IDLE_TIMEOUT";
 }  // namespace
 
 template <typename T>
@@ -71,9 +77,15 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
       libinput_event_loop_ = sd_event_unref(libinput_event_loop_);
       return;
     }
+
+    RegisterIdleTimer();
   }
 
   ~ELinuxWindowDrm() {
+    if (idle_timer_) {
+      sd_event_source_unref(idle_timer_);
+    }
+
     if (udev_drm_event_loop_) {
       sd_event_unref(udev_drm_event_loop_);
     }
@@ -106,6 +118,20 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
     return true;
   }
 
+  // |FlutterWindowBindingHandler|
+  std::vector<int> GetPollFds() const override {
+    // Each sd-event loop exposes a single epoll fd which covers all of its
+    // sources, including the idle timer.
+    std::vector<int> fds;
+    if (libinput_event_loop_) {
+      fds.push_back(sd_event_get_fd(libinput_event_loop_));
+    }
+    if (udev_drm_event_loop_) {
+      fds.push_back(sd_event_get_fd(udev_drm_event_loop_));
+    }
+    return fds;
+  }
+
   // |FlutterWindowBindingHandler|
   bool CreateRenderSurface(int32_t width, int32_t height) override {
     auto device_filename = std::getenv(kFlutterDrmDeviceEnvironmentKey);
@@ -115,7 +141,10 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
       device_filename = const_cast<char*>(kDrmDeviceDefaultFilename);
     }
 
-    native_window_ = std::make_unique<T>(device_filename, current_rotation_);
+    native_window_ = std::make_unique<T>(
+        device_filename, current_rotation_,
+        view_properties_.use_display_rotation,
+        view_properties_.use_variable_refresh_rate);
     if (!native_window_->IsValid()) {
       ELINUX_LOG(ERROR) << "Failed to create the native window";
       return false;
@@ -170,6 +199,11 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
   // |FlutterWindowBindingHandler|
   uint16_t GetRotationDegree() const override { return current_rotation_; }
 
+  // |FlutterWindowBindingHandler|
+  bool IsRotationAppliedByDisplay() const override {
+    return native_window_ && native_window_->IsPlaneRotationEnabled();
+  }
+
   // |FlutterWindowBindingHandler|
   double GetDpiScale() override { return current_scale_; }
 
@@ -179,7 +213,9 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
   }
 
   // |FlutterWindowBindingHandler|
-  int32_t GetFrameRate() override { return 60000; }
+  int32_t GetFrameRate() override {
+    return native_window_ ? native_window_->GetFrameRate() : 60000;
+  }
 
   // |FlutterWindowBindingHandler|
   void UpdateFlutterCursor(const std::string& cursor_name) override {
@@ -193,6 +229,13 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
     // currently not supported.
   }
 
+  // |FlutterWindowBindingHandler|
+  void UpdateVirtualKeyboardSurroundingText(const std::string& text,
+                                            size_t cursor,
+                                            size_t anchor) override {
+    // currently not supported.
+  }
+
   // |FlutterWindowBindingHandler|
   std::string GetClipboardData() override { return clipboard_data_; }
 
@@ -295,8 +338,17 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
       return -1;
     }
 
+    auto frame_rate = self->native_window_->GetFrameRate();
     if (self->IsUdevEventHotplug(*device) &&
-        self->native_window_->ConfigureDisplay(self->current_rotation_)) {
+        self->native_window_->ConfigureDisplay(
+            self->current_rotation_, self->GetUdevEventConnectorId(*device))) {
+      if (self->native_window_->GetFrameRate() != frame_rate) {
+        ELINUX_LOG(INFO) << "Display frame rate: "
+                         << self->native_window_->GetFrameRate() << " mHz";
+        if (self->binding_handler_delegate_) {
+          self->binding_handler_delegate_->OnDisplayChanged();
+        }
+      }
       auto width = self->native_window_->Width();
       auto height = self->native_window_->Height();
       if (self->current_rotation_ == 90 || self->current_rotation_ == 270) {
@@ -342,6 +394,15 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
     return std::strcmp(value, kPropertyOn) == 0;
   }
 
+  // Returns the connector which caused the hotplug event, or 0 if the kernel
+  // doesn't tell it.
+  uint32_t GetUdevEventConnectorId(udev_device& device) {
+    constexpr char kUdevPropertyKeyConnector[] = "CONNECTOR";
+    auto value =
+        udev_device_get_property_value(&device, kUdevPropertyKeyConnector);
+    return value ? std::strtoul(value, nullptr, 10) : 0;
+  }
+
   static int OnLibinputEvent(sd_event_source* source,
                              int fd,
                              uint32_t revents,
@@ -359,6 +420,10 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
     while (libinput_next_event_type(self->libinput_) != LIBINPUT_EVENT_NONE) {
       auto event = libinput_get_event(self->libinput_);
       auto event_type = libinput_event_get_type(event);
+      if (event_type != LIBINPUT_EVENT_DEVICE_ADDED &&
+          event_type != LIBINPUT_EVENT_DEVICE_REMOVED) {
+        self->OnUserActivity();
+      }
 
       switch (event_type) {
         case LIBINPUT_EVENT_DEVICE_ADDED:
@@ -412,6 +477,73 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
     return 0;
   }
 
+  void RegisterIdleTimer() {
+    auto timeout = std::getenv(kFlutterDrmIdleTimeoutEnvironmentKey);
+    if (!timeout || std::atoi(timeout) <= 0) {
+      return;
+    }
+    idle_timeout_usec_ = static_cast<uint64_t>(std::atoi(timeout)) * 1000000;
+
+    uint64_t now;
+    sd_event_now(libinput_event_loop_, CLOCK_MONOTONIC, &now);
+    last_input_time_usec_ = now;
+    if (sd_event_add_time(libinput_event_loop_, &idle_timer_, CLOCK_MONOTONIC,
+                          now + idle_timeout_usec_, 0, OnIdleTimer,
+                          this) < 0) {
+      ELINUX_LOG(ERROR) << "Failed to add the idle timer.";
+      idle_timeout_usec_ = 0;
+      return;
+    }
+    // The timer is re-armed from its callback.
+    sd_event_source_set_enabled(idle_timer_, SD_EVENT_ONESHOT);
+    ELINUX_LOG(INFO) << "Display idle timeout: " << timeout << " sec";
+  }
+
+  static int OnIdleTimer(sd_event_source* source, uint64_t usec, void* data) {
+    auto self = reinterpret_cast<ELinuxWindowDrm*>(data);
+    // Inputs only record their time, so the timer may expire early.
+    auto deadline = self->last_input_time_usec_ + self->idle_timeout_usec_;
+    if (usec >= deadline) {
+      if (self->SetDisplayPower(false)) {
+        // Nothing to do until the next input, which re-arms the timer.
+        return 0;
+      }
+      // Try again after another timeout rather than never blanking.
+      deadline = usec + self->idle_timeout_usec_;
+    }
+    sd_event_source_set_time(source, deadline);
+    sd_event_source_set_enabled(source, SD_EVENT_ONESHOT);
+    return 0;
+  }
+
+  // Restarts the idle timeout, turning the display back on if it's blanked.
+  void OnUserActivity() {
+    if (!idle_timer_) {
+      return;
+    }
+    sd_event_now(libinput_event_loop_, CLOCK_MONOTONIC,
+                 &last_input_time_usec_);
+    if (!display_power_on_) {
+      SetDisplayPower(true);
+      sd_event_source_set_time(idle_timer_,
+                               last_input_time_usec_ + idle_timeout_usec_);
+      sd_event_source_set_enabled(idle_timer_, SD_EVENT_ONESHOT);
+    }
+  }
+
+  // Returns false if the display power couldn't be changed.
+  bool SetDisplayPower(bool on) {
+    if (!native_window_ || !native_window_->SetDisplayPower(on)) {
+      return false;
+    }
+    display_power_on_ = on;
+    ELINUX_LOG(INFO) << "Display power: " << (on ? "on" : "off");
+    if (binding_handler_delegate_) {
+      binding_handler_delegate_->OnDisplayPowerChanged(on);
+    }
+    return true;
+  }
+
   void OnDeviceAdded(libinput_event* event) {
     auto device = libinput_event_get_device(event);
     auto device_data = std::make_unique<LibinputDeviceData>();
@@ -681,12 +813,18 @@ class ELinuxWindowDrm : public ELinuxWindow, public WindowBindingHandler {
 
   bool display_valid_;
   bool is_pending_cursor_add_event_;
-  sd_event* libinput_event_loop_;
+  sd_event* libinput_event_loop_ = nullptr;
   libinput* libinput_;
   std::unordered_map<size_t, std::unique_ptr<LibinputDeviceData>>
       libinput_devices_;
   int libinput_pointer_devices_ = 0;
 
+  // Idle display blanking.
+  sd_event_source* idle_timer_ = nullptr;
+  uint64_t idle_timeout_usec_ = 0;
+  uint64_t last_input_time_usec_ = 0;
+  bool display_power_on_ = true;
+
   sd_event* udev_drm_event_loop_ = nullptr;
   udev_monitor* udev_monitor_ = nullptr;
   int drm_device_id_;
@@ -13,6 +13,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <mutex>
 #include <unordered_map>
 
 #include "flutter/shell/platform/linux_embedded/logger.h"
@@ -40,6 +41,52 @@ constexpr char kWlCursorThemeWatch[] = "watch";
 constexpr char kCursorNameNone[] = "none";
 
 constexpr char kClipboardMimeTypeText[] = "text/plain";
+
+// The compositor applies the inverse of the buffer transform, which is
+// counter-clockwise, so this rotates the frames clockwise as the view
+// rotation does.
+wl_output_transform GetBufferTransform(uint16_t rotation) {
+  switch (rotation) {
+    case 90:
+      return WL_OUTPUT_TRANSFORM_90;
+    case 180:
+      return WL_OUTPUT_TRANSFORM_180;
+    case 270:
+      return WL_OUTPUT_TRANSFORM_270;
+    default:
+      return WL_OUTPUT_TRANSFORM_NORMAL;
+  }
+}
+
+// Windows in one process share a Wayland connection, and therefore one
+// EGLDisplay, so that their engines can be in one GL share group. Each window
+// binds its own globals on its own event queue, so that it only dispatches
+// its own events and windows can be run from different threads, and ignores
+// input for the other windows.
+std::mutex shared_display_mutex;
+wl_display* shared_display = nullptr;
+int shared_display_users = 0;
+
+wl_display* AcquireSharedDisplay() {
+  std::lock_guard<std::mutex> lock(shared_display_mutex);
+  if (!shared_display) {
+    shared_display = wl_display_connect(nullptr);
+    if (!shared_display) {
+      return nullptr;
+    }
+  }
+  shared_display_users++;
+  return shared_display;
+}
+
+void ReleaseSharedDisplay() {
+  std::lock_guard<std::mutex> lock(shared_display_mutex);
+  if (--shared_display_users == 0) {
+    wl_display_flush(shared_display);
+    wl_display_disconnect(shared_display);
+    shared_display = nullptr;
+  }
+}
 }  // namespace
 
 const wl_registry_listener ELinuxWindowWayland::kWlRegistryListener = {
@@ -134,13 +181,7 @@ const xdg_toplevel_listener ELinuxWindowWayland::kXdgToplevelListener = {
 
           self->view_properties_.width = next_width;
           self->view_properties_.height = next_height;
-          if (self->window_decorations_) {
-            self->window_decorations_->Resize(next_width, next_height);
-          }
-          if (self->binding_handler_delegate_) {
-            self->binding_handler_delegate_->OnWindowSizeChanged(next_width,
-                                                                 next_height);
-          }
+          self->NotifyWindowSizeChanged();
         },
     .close =
         [](void* data, xdg_toplevel* xdg_toplevel) {
@@ -157,6 +198,39 @@ const wp_presentation_listener ELinuxWindowWayland::kWpPresentationListener = {
         },
 };
 
+#if defined(USE_WAYLAND_FRACTIONAL_SCALE)
+const wp_fractional_scale_v1_listener
+    ELinuxWindowWayland::kWpFractionalScaleV1Listener = {
+        .preferred_scale =
+            [](void* data,
+               wp_fractional_scale_v1* wp_fractional_scale_v1,
+               uint32_t scale) {
+              auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+              // The scale is sent as a numerator with a denominator of 120.
+              const double next_scale = scale / 120.0;
+              if (self->buffer_scale_ == next_scale &&
+                  self->current_scale_ == next_scale) {
+                return;
+              }
+              ELINUX_LOG(INFO) << "Preferred fractional scale: " << next_scale;
+              self->buffer_scale_ = next_scale;
+              self->current_scale_ = next_scale;
+
+              // The window size is in surface coordinates, which shrink as
+              // the scale grows.
+              if (self->view_properties_.view_mode ==
+                      FlutterDesktopViewMode::kFullscreen &&
+                  self->output_width_ && self->output_height_) {
+                self->view_properties_.width =
+                    std::lround(self->output_width_ / next_scale);
+                self->view_properties_.height =
+                    std::lround(self->output_height_ / next_scale);
+              }
+              self->NotifyWindowSizeChanged();
+            },
+};
+#endif
+
 const wp_presentation_feedback_listener
     ELinuxWindowWayland::kWpPresentationFeedbackListener = {
         .sync_output =
@@ -258,6 +332,10 @@ const wl_pointer_listener ELinuxWindowWayland::kWlPointerListener = {
                 wl_fixed_t surface_x,
                 wl_fixed_t surface_y) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      self->pointer_focused_ = self->IsOwnSurface(surface);
+      if (!self->pointer_focused_) {
+        return;
+      }
       self->wl_current_surface_ = surface;
       self->serial_ = serial;
 
@@ -267,8 +345,8 @@ const wl_pointer_listener ELinuxWindowWayland::kWlPointerListener = {
       }
 
       if (self->binding_handler_delegate_) {
-        double x = wl_fixed_to_double(surface_x);
-        double y = wl_fixed_to_double(surface_y);
+        double x = self->ToBufferCoordinate(surface_x);
+        double y = self->ToBufferCoordinate(surface_y);
         self->binding_handler_delegate_->OnPointerMove(x, y);
         self->pointer_x_ = x;
         self->pointer_y_ = y;
@@ -279,6 +357,10 @@ const wl_pointer_listener ELinuxWindowWayland::kWlPointerListener = {
                 uint32_t serial,
                 wl_surface* surface) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      if (!self->pointer_focused_) {
+        return;
+      }
+      self->pointer_focused_ = false;
       self->wl_current_surface_ = surface;
       self->serial_ = serial;
 
@@ -294,9 +376,9 @@ const wl_pointer_listener ELinuxWindowWayland::kWlPointerListener = {
                  wl_fixed_t surface_x,
                  wl_fixed_t surface_y) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-      if (self->binding_handler_delegate_) {
-        double x = wl_fixed_to_double(surface_x);
-        double y = wl_fixed_to_double(surface_y);
+      if (self->pointer_focused_ && self->binding_handler_delegate_) {
+        double x = self->ToBufferCoordinate(surface_x);
+        double y = self->ToBufferCoordinate(surface_y);
         self->binding_handler_delegate_->OnPointerMove(x, y);
         self->pointer_x_ = x;
         self->pointer_y_ = y;
@@ -309,6 +391,9 @@ const wl_pointer_listener ELinuxWindowWayland::kWlPointerListener = {
                  uint32_t button,
                  uint32_t status) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      if (!self->pointer_focused_) {
+        return;
+      }
       self->serial_ = serial;
 
       if (button == BTN_LEFT && status == WL_POINTER_BUTTON_STATE_PRESSED) {
@@ -396,7 +481,7 @@ const wl_pointer_listener ELinuxWindowWayland::kWlPointerListener = {
                uint32_t axis,
                wl_fixed_t value) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-      if (self->binding_handler_delegate_) {
+      if (self->pointer_focused_ && self->binding_handler_delegate_) {
         double delta = wl_fixed_to_double(value);
         constexpr int32_t kScrollOffsetMultiplier = 20;
         self->binding_handler_delegate_->OnScroll(
@@ -418,10 +503,14 @@ const wl_touch_listener ELinuxWindowWayland::kWlTouchListener = {
                wl_fixed_t surface_x,
                wl_fixed_t surface_y) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      if (!self->IsOwnSurface(surface)) {
+        return;
+      }
+      self->touch_ids_.push_back(id);
       self->serial_ = serial;
       if (self->binding_handler_delegate_) {
-        double x = wl_fixed_to_double(surface_x);
-        double y = wl_fixed_to_double(surface_y);
+        double x = self->ToBufferCoordinate(surface_x);
+        double y = self->ToBufferCoordinate(surface_y);
         self->binding_handler_delegate_->OnTouchDown(time, id, x, y);
       }
     },
@@ -431,6 +520,11 @@ const wl_touch_listener ELinuxWindowWayland::kWlTouchListener = {
              uint32_t time,
              int32_t id) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      auto it = std::find(self->touch_ids_.begin(), self->touch_ids_.end(), id);
+      if (it == self->touch_ids_.end()) {
+        return;
+      }
+      self->touch_ids_.erase(it);
       self->serial_ = serial;
       if (self->binding_handler_delegate_) {
         self->binding_handler_delegate_->OnTouchUp(time, id);
@@ -443,15 +537,23 @@ const wl_touch_listener ELinuxWindowWayland::kWlTouchListener = {
                  wl_fixed_t surface_x,
                  wl_fixed_t surface_y) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      if (std::find(self->touch_ids_.begin(), self->touch_ids_.end(), id) ==
+          self->touch_ids_.end()) {
+        return;
+      }
       if (self->binding_handler_delegate_) {
-        double x = wl_fixed_to_double(surface_x);
-        double y = wl_fixed_to_double(surface_y);
+        double x = self->ToBufferCoordinate(surface_x);
+        double y = self->ToBufferCoordinate(surface_y);
         self->binding_handler_delegate_->OnTouchMotion(time, id, x, y);
       }
     },
     .frame = [](void* data, wl_touch* wl_touch) -> void {},
     .cancel = [](void* data, wl_touch* wl_touch) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      if (self->touch_ids_.empty()) {
+        return;
+      }
+      self->touch_ids_.clear();
       if (self->binding_handler_delegate_) {
         self->binding_handler_delegate_->OnTouchCancel();
       }
@@ -476,14 +578,20 @@ const wl_keyboard_listener ELinuxWindowWayland::kWlKeyboardListener = {
                 wl_surface* surface,
                 wl_array* keys) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-      self->serial_ = serial;
+      self->keyboard_focused_ = self->IsOwnSurface(surface);
+      if (self->keyboard_focused_) {
+        self->serial_ = serial;
+      }
     },
     .leave = [](void* data,
                 wl_keyboard* wl_keyboard,
                 uint32_t serial,
                 wl_surface* surface) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-      self->serial_ = serial;
+      if (self->keyboard_focused_) {
+        self->keyboard_focused_ = false;
+        self->serial_ = serial;
+      }
     },
     .key = [](void* data,
               wl_keyboard* wl_keyboard,
@@ -492,6 +600,9 @@ const wl_keyboard_listener ELinuxWindowWayland::kWlKeyboardListener = {
               uint32_t key,
               uint32_t state) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+      if (!self->keyboard_focused_) {
+        return;
+      }
       self->serial_ = serial;
       if (self->binding_handler_delegate_) {
         self->binding_handler_delegate_->OnKey(
@@ -506,7 +617,7 @@ const wl_keyboard_listener ELinuxWindowWayland::kWlKeyboardListener = {
                     uint32_t mods_locked,
                     uint32_t group) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-      if (self->binding_handler_delegate_) {
+      if (self->keyboard_focused_ && self->binding_handler_delegate_) {
         self->binding_handler_delegate_->OnKeyModifiers(
             mods_depressed, mods_latched, mods_locked, group);
       }
@@ -546,18 +657,15 @@ const wl_output_listener ELinuxWindowWayland::kWlOutputListener = {
           self->frame_rate_ = refresh;
         }
 
+        self->output_width_ = width;
+        self->output_height_ = height;
         if (self->view_properties_.view_mode ==
             FlutterDesktopViewMode::kFullscreen) {
-          self->view_properties_.width = width;
-          self->view_properties_.height = height;
-
-          if (self->window_decorations_) {
-            self->window_decorations_->Resize(width, height);
-          }
-
-          if (self->binding_handler_delegate_) {
-            self->binding_handler_delegate_->OnWindowSizeChanged(width, height);
-          }
+          self->view_properties_.width =
+              std::lround(width / self->buffer_scale_);
+          self->view_properties_.height =
+              std::lround(height / self->buffer_scale_);
+          self->NotifyWindowSizeChanged();
         }
       }
     },
@@ -565,7 +673,9 @@ const wl_output_listener ELinuxWindowWayland::kWlOutputListener = {
     .scale = [](void* data, wl_output* wl_output, int32_t scale) -> void {
       auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
       ELINUX_LOG(INFO) << "Display output scale: " << scale;
-      if (!self->view_properties_.force_scale_factor)
+      // The preferred fractional scale takes precedence.
+      if (!self->view_properties_.force_scale_factor &&
+          !self->wp_fractional_scale_v1_)
         self->current_scale_ = scale;
     },
 };
@@ -576,12 +686,7 @@ const zwp_text_input_v1_listener ELinuxWindowWayland::kZwpTextInputV1Listener =
                     zwp_text_input_v1* zwp_text_input_v1,
                     wl_surface* surface) -> void {
           auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-          // If there is no input data, the backspace key cannot be used,
-          // so set dummy data.
-          if (self->zwp_text_input_v1_) {
-            zwp_text_input_v1_set_surrounding_text(self->zwp_text_input_v1_,
-                                                   " ", 1, 1);
-          }
+          self->SendSurroundingText();
         },
         .leave = [](void* data, zwp_text_input_v1* zwp_text_input_v1) -> void {
           auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
@@ -606,10 +711,7 @@ const zwp_text_input_v1_listener ELinuxWindowWayland::kZwpTextInputV1Listener =
           }
           if (self->zwp_text_input_v1_) {
             zwp_text_input_v1_reset(self->zwp_text_input_v1_);
-            // If there is no input data, the backspace key cannot be used,
-            // so set dummy data.
-            zwp_text_input_v1_set_surrounding_text(self->zwp_text_input_v1_,
-                                                   " ", 1, 1);
+            self->SendSurroundingText();
           }
         },
         .preedit_styling = [](void* data,
@@ -629,12 +731,6 @@ const zwp_text_input_v1_listener ELinuxWindowWayland::kZwpTextInputV1Listener =
           if (self->binding_handler_delegate_ && strlen(text)) {
             self->binding_handler_delegate_->OnVirtualKey(text[0]);
           }
-          // If there is no input data, the backspace key cannot be used,
-          // so set dummy data.
-          if (self->zwp_text_input_v1_) {
-            zwp_text_input_v1_set_surrounding_text(self->zwp_text_input_v1_,
-                                                   " ", 1, 1);
-          }
         },
         .cursor_position = [](void* data,
                               zwp_text_input_v1* zwp_text_input_v1,
@@ -644,16 +740,9 @@ const zwp_text_input_v1_listener ELinuxWindowWayland::kZwpTextInputV1Listener =
                                       zwp_text_input_v1* zwp_text_input_v1,
                                       int32_t index,
                                       uint32_t length) -> void {
+          // Sent before the commit_string which replaces the deleted text.
           auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-          if (self->binding_handler_delegate_) {
-            self->binding_handler_delegate_->OnVirtualSpecialKey(KEY_BACKSPACE);
-          }
-          // If there is no input data, the backspace key cannot be used,
-          // so set dummy data.
-          if (self->zwp_text_input_v1_) {
-            zwp_text_input_v1_set_surrounding_text(self->zwp_text_input_v1_,
-                                                   " ", 1, 1);
-          }
+          self->DeleteSurroundingText(index, length);
         },
         .keysym = [](void* data,
                      zwp_text_input_v1* zwp_text_input_v1,
@@ -723,17 +812,37 @@ const zwp_text_input_v3_listener ELinuxWindowWayland::kZwpTextInputV3Listener =
                             zwp_text_input_v3* zwp_text_input_v3,
                             const char* text) -> void {
           auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
-          if (self->binding_handler_delegate_ && strlen(text)) {
-            self->binding_handler_delegate_->OnVirtualKey(text[0]);
-          }
+          self->pending_commit_string_ = text ? text : "";
         },
         .delete_surrounding_text = [](void* data,
                                       zwp_text_input_v3* zwp_text_input_v3,
                                       uint32_t before_length,
-                                      uint32_t after_length) -> void {},
+                                      uint32_t after_length) -> void {
+          auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+          self->pending_delete_before_length_ = before_length;
+          self->pending_delete_after_length_ = after_length;
+        },
         .done = [](void* data,
                    zwp_text_input_v3* zwp_text_input_v3,
-                   uint32_t serial) -> void {},
+                   uint32_t serial) -> void {
+          // The deletion applies to the text before the commit string is
+          // inserted.
+          auto self = reinterpret_cast<ELinuxWindowWayland*>(data);
+          uint32_t before_length = self->pending_delete_before_length_;
+          uint32_t after_length = self->pending_delete_after_length_;
+          if (before_length || after_length) {
+            self->DeleteSurroundingText(-static_cast<int64_t>(before_length),
+                                        before_length + after_length);
+          }
+          if (self->binding_handler_delegate_ &&
+              !self->pending_commit_string_.empty()) {
+            self->binding_handler_delegate_->OnVirtualKey(
+                self->pending_commit_string_[0]);
+          }
+          self->pending_commit_string_.clear();
+          self->pending_delete_before_length_ = 0;
+          self->pending_delete_after_length_ = 0;
+        },
 };
 
 const wl_data_device_listener ELinuxWindowWayland::kWlDataDeviceListener = {
@@ -834,21 +943,39 @@ ELinuxWindowWayland::ELinuxWindowWayland(
       view_properties.force_scale_factor ? view_properties.scale_factor : 1.0;
   SetRotation(view_properties_.view_rotation);
 
-  wl_display_ = wl_display_connect(nullptr);
+  wl_display_ = AcquireSharedDisplay();
   if (!wl_display_) {
     ELINUX_LOG(ERROR) << "Failed to connect to the Wayland display.";
     return;
   }
 
-  wl_registry_ = wl_display_get_registry(wl_display_);
+  wl_event_queue_ = wl_display_create_queue(wl_display_);
+  if (!wl_event_queue_) {
+    ELINUX_LOG(ERROR) << "Failed to create the wayland event queue.";
+    return;
+  }
+
+  // Proxies inherit the queue of the proxy they are created from, so binding
+  // the globals through a registry on this window's queue puts all of its
+  // objects there.
+  auto* display_wrapper =
+      static_cast<wl_display*>(wl_proxy_create_wrapper(wl_display_));
+  if (!display_wrapper) {
+    ELINUX_LOG(ERROR) << "Failed to create the wayland display wrapper.";
+    return;
+  }
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(display_wrapper),
+                     wl_event_queue_);
+  wl_registry_ = wl_display_get_registry(display_wrapper);
+  wl_proxy_wrapper_destroy(display_wrapper);
   if (!wl_registry_) {
     ELINUX_LOG(ERROR) << "Failed to get the wayland registry.";
     return;
   }
 
   wl_registry_add_listener(wl_registry_, &kWlRegistryListener, this);
-  wl_display_dispatch(wl_display_);
-  wl_display_roundtrip(wl_display_);
+  wl_display_dispatch_queue(wl_display_, wl_event_queue_);
+  wl_display_roundtrip_queue(wl_display_, wl_event_queue_);
 
   if (wl_data_device_manager_ && wl_seat_) {
     wl_data_device_ = wl_data_device_manager_get_data_device(
@@ -971,6 +1098,25 @@ ELinuxWindowWayland::~ELinuxWindowWayland() {
     wl_shm_ = nullptr;
   }
 
+#if defined(USE_WAYLAND_FRACTIONAL_SCALE)
+  if (wp_fractional_scale_manager_v1_) {
+    wp_fractional_scale_manager_v1_destroy(wp_fractional_scale_manager_v1_);
+    wp_fractional_scale_manager_v1_ = nullptr;
+  }
+#endif
+
+  if (wp_viewporter_) {
+    wp_viewporter_destroy(wp_viewporter_);
+    wp_viewporter_ = nullptr;
+  }
+
+#if defined(USE_WAYLAND_DMABUF)
+  if (zwp_linux_dmabuf_v1_) {
+    zwp_linux_dmabuf_v1_destroy(zwp_linux_dmabuf_v1_);
+    zwp_linux_dmabuf_v1_ = nullptr;
+  }
+#endif
+
   if (xdg_toplevel_) {
     xdg_toplevel_destroy(xdg_toplevel_);
     xdg_toplevel_ = nullptr;
@@ -996,13 +1142,37 @@ ELinuxWindowWayland::~ELinuxWindowWayland() {
     wl_registry_ = nullptr;
   }
 
+  if (wl_event_queue_) {
+    wl_event_queue_destroy(wl_event_queue_);
+    wl_event_queue_ = nullptr;
+  }
+
   if (wl_display_) {
-    wl_display_flush(wl_display_);
-    wl_display_disconnect(wl_display_);
+    ReleaseSharedDisplay();
     wl_display_ = nullptr;
   }
 }
 
+bool ELinuxWindowWayland::IsOwnSurface(wl_surface* surface) const {
+  if (!surface) {
+    return false;
+  }
+  if (native_window_ && native_window_->Surface() == surface) {
+    return true;
+  }
+  if (window_decorations_) {
+    for (auto type : {WindowDecoration::DecorationType::TITLE_BAR,
+                      WindowDecoration::DecorationType::CLOSE_BUTTON,
+                      WindowDecoration::DecorationType::MAXIMISE_BUTTON,
+                      WindowDecoration::DecorationType::MINIMISE_BUTTON}) {
+      if (window_decorations_->IsMatched(surface, type)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 void ELinuxWindowWayland::SetView(WindowBindingHandlerDelegate* window) {
   binding_handler_delegate_ = window;
 }
@@ -1015,12 +1185,17 @@ uint16_t ELinuxWindowWayland::GetRotationDegree() const {
   return current_rotation_;
 }
 
+bool ELinuxWindowWayland::IsRotationAppliedByDisplay() const {
+  return use_buffer_transform_;
+}
+
 double ELinuxWindowWayland::GetDpiScale() {
   return current_scale_;
 }
 
 PhysicalWindowBounds ELinuxWindowWayland::GetPhysicalWindowBounds() {
-  return {GetCurrentWidth(), GetCurrentHeight()};
+  return {static_cast<size_t>(ToBufferSize(GetCurrentWidth())),
+          static_cast<size_t>(ToBufferSize(GetCurrentHeight()))};
 }
 
 int32_t ELinuxWindowWayland::GetFrameRate() {
@@ -1037,10 +1212,13 @@ bool ELinuxWindowWayland::DispatchEvent() {
     return false;
   }
 
-  // Prepare to call wl_display_read_events.
-  while (wl_display_prepare_read(wl_display_) != 0) {
+  // Prepare to call wl_display_read_events. Reading is shared by all the
+  // windows on the connection, and whichever reads queues the events of the
+  // others on their own queues.
+  while (wl_display_prepare_read_queue(wl_display_, wl_event_queue_) != 0) {
     // If Wayland compositor terminates, -1 is returned.
-    auto result = wl_display_dispatch_pending(wl_display_);
+    auto result =
+        wl_display_dispatch_queue_pending(wl_display_, wl_event_queue_);
     if (result == -1) {
       return false;
     }
@@ -1064,7 +1242,7 @@ bool ELinuxWindowWayland::DispatchEvent() {
       return false;
     }
 
-    result = wl_display_dispatch_pending(wl_display_);
+    result = wl_display_dispatch_queue_pending(wl_display_, wl_event_queue_);
     if (result == -1) {
       return false;
     }
@@ -1075,6 +1253,13 @@ bool ELinuxWindowWayland::DispatchEvent() {
   return true;
 }
 
+std::vector<int> ELinuxWindowWayland::GetPollFds() const {
+  if (!wl_display_) {
+    return {};
+  }
+  return {wl_display_get_fd(wl_display_)};
+}
+
 bool ELinuxWindowWayland::CreateRenderSurface(int32_t width, int32_t height) {
   if (!display_valid_) {
     ELINUX_LOG(ERROR) << "Wayland display is invalid.";
@@ -1107,11 +1292,40 @@ bool ELinuxWindowWayland::CreateRenderSurface(int32_t width, int32_t height) {
     }
   }
 
+  // With the buffer transform, the buffer keeps the view orientation and the
+  // compositor rotates it into the surface.
+  auto use_display_rotation = view_properties_.use_display_rotation;
+#if defined(USE_VULKAN)
+  // The engine doesn't transform the root surface with Vulkan.
+  use_display_rotation = true;
+#endif
+  use_buffer_transform_ = use_display_rotation && current_rotation_ != 0 &&
+                          wl_compositor_get_version(wl_compositor_) >=
+                              WL_SURFACE_SET_BUFFER_TRANSFORM_SINCE_VERSION;
+  const auto buffer_width = width;
+  const auto buffer_height = height;
   if (current_rotation_ == 90 || current_rotation_ == 270) {
     std::swap(width, height);
   }
-  native_window_ =
-      std::make_unique<NativeWindowWayland>(wl_compositor_, width, height);
+  if (use_buffer_transform_) {
+    native_window_ = CreateNativeWindow(buffer_width, buffer_height);
+    wl_surface_set_buffer_transform(native_window_->Surface(),
+                                    GetBufferTransform(current_rotation_));
+  } else {
+    if (use_display_rotation && current_rotation_ != 0) {
+#if defined(USE_VULKAN)
+      ELINUX_LOG(WARNING) << "The compositor doesn't support buffer "
+                             "transforms, so the view isn't rotated: the "
+                             "engine doesn't rotate Vulkan frames.";
+#else
+      ELINUX_LOG(WARNING) << "The compositor doesn't support buffer "
+                             "transforms, the frames are rotated by the GPU.";
+#endif
+    }
+    native_window_ = CreateNativeWindow(width, height);
+  }
+
+  SetupFractionalScale();
 
   xdg_surface_ =
       xdg_wm_base_get_xdg_surface(xdg_wm_base_, native_window_->Surface());
@@ -1138,8 +1352,12 @@ bool ELinuxWindowWayland::CreateRenderSurface(int32_t width, int32_t height) {
     }
   }
 
+#if defined(USE_VULKAN)
+  render_surface_ = std::make_unique<SurfaceVulkan>(wl_display_);
+#else
   render_surface_ = std::make_unique<SurfaceGl>(std::make_unique<ContextEgl>(
       std::make_unique<EnvironmentEgl>(wl_display_)));
+#endif
   render_surface_->SetNativeWindow(native_window_.get());
 
   if (view_properties_.use_window_decoration) {
@@ -1157,6 +1375,18 @@ void ELinuxWindowWayland::DestroyRenderSurface() {
     window_decorations_ = nullptr;
   }
   render_surface_ = nullptr;
+
+#if defined(USE_WAYLAND_FRACTIONAL_SCALE)
+  if (wp_fractional_scale_v1_) {
+    wp_fractional_scale_v1_destroy(wp_fractional_scale_v1_);
+    wp_fractional_scale_v1_ = nullptr;
+  }
+#endif
+  if (wp_viewport_) {
+    wp_viewport_destroy(wp_viewport_);
+    wp_viewport_ = nullptr;
+  }
+  buffer_scale_ = 1.0;
   native_window_ = nullptr;
 
   if (xdg_surface_) {
@@ -1170,6 +1400,68 @@ void ELinuxWindowWayland::DestroyRenderSurface() {
   }
 }
 
+std::unique_ptr<NativeWindowWayland> ELinuxWindowWayland::CreateNativeWindow(
+    int32_t width,
+    int32_t height) {
+#if defined(USE_WAYLAND_DMABUF)
+  if (zwp_linux_dmabuf_v1_) {
+    return std::make_unique<NativeWindowWaylandDmabuf>(
+        wl_display_, wl_compositor_, zwp_linux_dmabuf_v1_, width, height);
+  }
+  ELINUX_LOG(WARNING) << "The compositor doesn't support the dmabuf feedback. "
+                         "Falling back to the EGL window.";
+#endif
+  return std::make_unique<NativeWindowWayland>(wl_compositor_, width, height);
+}
+
+int32_t ELinuxWindowWayland::ToBufferSize(int32_t size) const {
+  return static_cast<int32_t>(std::lround(size * buffer_scale_));
+}
+
+double ELinuxWindowWayland::ToBufferCoordinate(wl_fixed_t value) const {
+  return wl_fixed_to_double(value) * buffer_scale_;
+}
+
+void ELinuxWindowWayland::SetupFractionalScale() {
+#if defined(USE_WAYLAND_FRACTIONAL_SCALE)
+  if (view_properties_.force_scale_factor) {
+    return;
+  }
+  if (!wp_viewporter_ || !wp_fractional_scale_manager_v1_) {
+    return;
+  }
+
+  wp_viewport_ =
+      wp_viewporter_get_viewport(wp_viewporter_, native_window_->Surface());
+  wp_fractional_scale_v1_ = wp_fractional_scale_manager_v1_get_fractional_scale(
+      wp_fractional_scale_manager_v1_, native_window_->Surface());
+  wp_fractional_scale_v1_add_listener(wp_fractional_scale_v1_,
+                                      &kWpFractionalScaleV1Listener, this);
+#endif
+}
+
+void ELinuxWindowWayland::NotifyWindowSizeChanged() {
+  const int32_t width = view_properties_.width;
+  const int32_t height = view_properties_.height;
+  if (window_decorations_) {
+    window_decorations_->Resize(width, height);
+  }
+
+  if (wp_viewport_) {
+    // The destination is in the surface orientation.
+    if (current_rotation_ == 90 || current_rotation_ == 270) {
+      wp_viewport_set_destination(wp_viewport_, height, width);
+    } else {
+      wp_viewport_set_destination(wp_viewport_, width, height);
+    }
+  }
+
+  if (binding_handler_delegate_) {
+    binding_handler_delegate_->OnWindowSizeChanged(ToBufferSize(width),
+                                                   ToBufferSize(height));
+  }
+}
+
 void ELinuxWindowWayland::UpdateVirtualKeyboardStatus(const bool show) {
   // Not supported virtual keyboard.
   if (!(zwp_text_input_v1_ || zwp_text_input_v3_) || !wl_seat_) {
@@ -1184,6 +1476,26 @@ void ELinuxWindowWayland::UpdateVirtualKeyboardStatus(const bool show) {
   }
 }
 
+void ELinuxWindowWayland::UpdateVirtualKeyboardSurroundingText(
+    const std::string& text,
+    size_t cursor,
+    size_t anchor) {
+  if (text == surrounding_text_ && cursor == surrounding_text_cursor_ &&
+      anchor == surrounding_text_anchor_) {
+    return;
+  }
+  surrounding_text_ = text;
+  surrounding_text_cursor_ = cursor;
+  surrounding_text_anchor_ = anchor;
+  if (!is_requested_show_virtual_keyboard_) {
+    return;
+  }
+  SendSurroundingText();
+  if (zwp_text_input_v3_) {
+    zwp_text_input_v3_commit(zwp_text_input_v3_);
+  }
+}
+
 void ELinuxWindowWayland::UpdateFlutterCursor(const std::string& cursor_name) {
   if (view_properties_.use_mouse_cursor) {
     if (cursor_name.compare(cursor_info_.cursor_name) == 0) {
@@ -1229,7 +1541,7 @@ std::string ELinuxWindowWayland::GetClipboardData() {
 
     wl_data_offer_receive(wl_data_offer_, kClipboardMimeTypeText, fd[1]);
     close(fd[1]);
-    wl_display_dispatch(wl_display_);
+    wl_display_dispatch_queue(wl_display_, wl_event_queue_);
 
     char buf[256];
     int len;
@@ -1373,6 +1685,38 @@ void ELinuxWindowWayland::WlRegistryHandler(wl_registry* wl_registry,
                                  this);
     return;
   }
+
+  if (!strcmp(interface, wp_viewporter_interface.name)) {
+    constexpr uint32_t kMaxVersion = 1;
+    wp_viewporter_ = static_cast<decltype(wp_viewporter_)>(wl_registry_bind(
+        wl_registry, name, &wp_viewporter_interface, kMaxVersion));
+    return;
+  }
+
+#if defined(USE_WAYLAND_FRACTIONAL_SCALE)
+  if (!strcmp(interface, wp_fractional_scale_manager_v1_interface.name)) {
+    constexpr uint32_t kMaxVersion = 1;
+    wp_fractional_scale_manager_v1_ =
+        static_cast<decltype(wp_fractional_scale_manager_v1_)>(
+            wl_registry_bind(wl_registry, name,
+                             &wp_fractional_scale_manager_v1_interface,
+                             kMaxVersion));
+    return;
+  }
+#endif
+
+#if defined(USE_WAYLAND_DMABUF)
+  if (!strcmp(interface, zwp_linux_dmabuf_v1_interface.name)) {
+    constexpr uint32_t kMinVersion =
+        ZWP_LINUX_DMABUF_V1_GET_SURFACE_FEEDBACK_SINCE_VERSION;
+    if (version >= kMinVersion) {
+      zwp_linux_dmabuf_v1_ = static_cast<decltype(zwp_linux_dmabuf_v1_)>(
+          wl_registry_bind(wl_registry, name, &zwp_linux_dmabuf_v1_interface,
+                           kMinVersion));
+    }
+    return;
+  }
+#endif
 }
 
 void ELinuxWindowWayland::WlUnRegistryHandler(wl_registry* wl_registry,
@@ -1474,6 +1818,7 @@ void ELinuxWindowWayland::ShowVirtualKeyboard() {
     zwp_text_input_v3_set_content_type(
         zwp_text_input_v3_, ZWP_TEXT_INPUT_V3_CONTENT_HINT_NONE,
         ZWP_TEXT_INPUT_V3_CONTENT_PURPOSE_TERMINAL);
+    SendSurroundingText();
     zwp_text_input_v3_commit(zwp_text_input_v3_);
   } else {
     if (native_window_) {
@@ -1484,6 +1829,65 @@ void ELinuxWindowWayland::ShowVirtualKeyboard() {
   }
 }
 
+void ELinuxWindowWayland::SendSurroundingText() {
+  if (zwp_text_input_v3_) {
+    zwp_text_input_v3_set_surrounding_text(
+        zwp_text_input_v3_, surrounding_text_.c_str(),
+        surrounding_text_cursor_, surrounding_text_anchor_);
+  } else if (zwp_text_input_v1_) {
+    // If there is no input data, the backspace key cannot be used, so set
+    // dummy data.
+    if (surrounding_text_.empty()) {
+      zwp_text_input_v1_set_surrounding_text(zwp_text_input_v1_, " ", 1, 1);
+    } else {
+      zwp_text_input_v1_set_surrounding_text(
+          zwp_text_input_v1_, surrounding_text_.c_str(),
+          surrounding_text_cursor_, surrounding_text_anchor_);
+    }
+  }
+}
+
+void ELinuxWindowWayland::DeleteSurroundingText(int64_t index,
+                                                uint64_t length) {
+  if (!binding_handler_delegate_) {
+    return;
+  }
+
+  // The range is in bytes of the text last sent to the input method, which
+  // is converted to code points of the edited text.
+  std::string text = surrounding_text_;
+  int64_t cursor = surrounding_text_cursor_;
+  bool dummy = text.empty() && !zwp_text_input_v3_;
+  if (dummy) {
+    text = " ";
+    cursor = 1;
+  }
+  const int64_t size = text.size();
+  int64_t start = std::clamp<int64_t>(cursor + index, 0, size);
+  int64_t end = std::clamp<int64_t>(start + static_cast<int64_t>(length),
+                                    start, size);
+  auto count_code_points = [&text](int64_t from, int64_t to) {
+    int count = 0;
+    for (auto i = from; i < to; i++) {
+      if ((static_cast<uint8_t>(text[i]) & 0xC0) != 0x80) {
+        count++;
+      }
+    }
+    return count;
+  };
+  int offset = start < cursor ? -count_code_points(start, cursor)
+                              : count_code_points(cursor, start);
+  int count = count_code_points(start, end);
+  if (count > 0) {
+    binding_handler_delegate_->OnVirtualDeleteSurroundingText(offset, count);
+  }
+  // The text sent to the input method doesn't change, so restore the dummy
+  // text which it has just deleted.
+  if (dummy) {
+    SendSurroundingText();
+  }
+}
+
 void ELinuxWindowWayland::DismissVirtualKeybaord() {
   if (zwp_text_input_v3_) {
     zwp_text_input_v3_disable(zwp_text_input_v3_);
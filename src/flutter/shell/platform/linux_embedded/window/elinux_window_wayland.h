@@ -15,18 +15,31 @@
 #include "flutter/shell/platform/linux_embedded/surface/surface_gl.h"
 #include "flutter/shell/platform/linux_embedded/window/elinux_window.h"
 #include "flutter/shell/platform/linux_embedded/window/native_window_wayland.h"
+#if defined(USE_WAYLAND_DMABUF)
+#include "flutter/shell/platform/linux_embedded/window/native_window_wayland_dmabuf.h"
+#endif
 #include "flutter/shell/platform/linux_embedded/window/renderer/window_decorations_wayland.h"
 #include "flutter/shell/platform/linux_embedded/window_binding_handler.h"
 
 // These header files are automatically generated by the
 // wayland-scanner.
 extern "C" {
+#if defined(USE_WAYLAND_FRACTIONAL_SCALE)
+#include "wayland/protocols/fractional-scale-v1-client-protocol.h"
+#endif
 #include "wayland/protocols/presentation-time-protocol.h"
 #include "wayland/protocols/text-input-unstable-v1-client-protocol.h"
 #include "wayland/protocols/text-input-unstable-v3-client-protocol.h"
+#include "wayland/protocols/viewporter-client-protocol.h"
 #include "wayland/protocols/xdg-shell-client-protocol.h"
 }
 
+#if !defined(USE_WAYLAND_FRACTIONAL_SCALE)
+// Built without fractional-scale-v1, whose objects are then never bound.
+struct wp_fractional_scale_manager_v1;
+struct wp_fractional_scale_v1;
+#endif
+
 namespace flutter {
 
 class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
@@ -40,6 +53,9 @@ class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
   // |FlutterWindowBindingHandler|
   bool DispatchEvent() override;
 
+  // |FlutterWindowBindingHandler|
+  std::vector<int> GetPollFds() const override;
+
   // |FlutterWindowBindingHandler|
   bool CreateRenderSurface(int32_t width, int32_t height) override;
 
@@ -55,6 +71,9 @@ class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
   // |FlutterWindowBindingHandler|
   uint16_t GetRotationDegree() const override;
 
+  // |FlutterWindowBindingHandler|
+  bool IsRotationAppliedByDisplay() const override;
+
   // |FlutterWindowBindingHandler|
   double GetDpiScale() override;
 
@@ -70,6 +89,11 @@ class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
   // |FlutterWindowBindingHandler|
   void UpdateVirtualKeyboardStatus(const bool show) override;
 
+  // |FlutterWindowBindingHandler|
+  void UpdateVirtualKeyboardSurroundingText(const std::string& text,
+                                            size_t cursor,
+                                            size_t anchor) override;
+
   // |FlutterWindowBindingHandler|
   std::string GetClipboardData() override;
 
@@ -92,12 +116,43 @@ class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
 
   void CreateSupportedWlCursorList();
 
+  // Returns true if |surface| belongs to this window. Other windows in the
+  // process share the connection, so input for them is also received.
+  bool IsOwnSurface(wl_surface* surface) const;
+
+  // Creates the window surface of |width| x |height| buffer pixels.
+  std::unique_ptr<NativeWindowWayland> CreateNativeWindow(int32_t width,
+                                                          int32_t height);
+
+  // Returns the size in buffer pixels of |size| in surface coordinates.
+  int32_t ToBufferSize(int32_t size) const;
+
+  // Converts a surface coordinate of an input event into buffer pixels, which
+  // the view expects.
+  double ToBufferCoordinate(wl_fixed_t value) const;
+
+  // Creates the objects which render the surface at the compositor's
+  // preferred fractional scale. Does nothing if built without
+  // fractional-scale-v1.
+  void SetupFractionalScale();
+
+  // Resizes the surface to the window size, and the buffer and the engine's
+  // window metrics to the matching size in pixels.
+  void NotifyWindowSizeChanged();
+
   wl_cursor* GetWlCursor(const std::string& cursor_name);
 
   void ShowVirtualKeyboard();
 
   void DismissVirtualKeybaord();
 
+  // Sends |surrounding_text_| to the input method.
+  void SendSurroundingText();
+
+  // Deletes |length| bytes starting |index| bytes past the cursor, in the
+  // surrounding text sent to the input method, from the edited text.
+  void DeleteSurroundingText(int64_t index, uint64_t length);
+
   static const wl_registry_listener kWlRegistryListener;
   static const xdg_wm_base_listener kXdgWmBaseListener;
   static const xdg_surface_listener kXdgSurfaceListener;
@@ -115,18 +170,23 @@ class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
   static const wp_presentation_listener kWpPresentationListener;
   static const wp_presentation_feedback_listener
       kWpPresentationFeedbackListener;
+#if defined(USE_WAYLAND_FRACTIONAL_SCALE)
+  static const wp_fractional_scale_v1_listener kWpFractionalScaleV1Listener;
+#endif
 
   // A pointer to a FlutterWindowsView that can be used to update engine
   // windowing and input state.
   WindowBindingHandlerDelegate* binding_handler_delegate_ = nullptr;
 
   std::unique_ptr<NativeWindowWayland> native_window_;
-  std::unique_ptr<SurfaceGl> render_surface_;
+  std::unique_ptr<ELinuxRenderSurfaceTarget> render_surface_;
 
   // decorations.
   std::unique_ptr<WindowDecorationsWayland> window_decorations_;
   wl_surface* wl_current_surface_;
   wl_subcompositor* wl_subcompositor_;
+  // The compositor rotates the frames with the buffer transform.
+  bool use_buffer_transform_ = false;
   bool restore_window_required_ = false;
   int32_t restore_window_width_;
   int32_t restore_window_height_;
@@ -136,11 +196,18 @@ class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
   bool maximised_;
   uint32_t last_frame_time_;
 
+  // Input focus of this window's surfaces.
+  bool pointer_focused_ = false;
+  bool keyboard_focused_ = false;
+  std::vector<int32_t> touch_ids_;
+
   // Indicates that exists a keyboard show request from Flutter Engine.
   bool is_requested_show_virtual_keyboard_;
 
   wl_display* wl_display_;
-  wl_registry* wl_registry_;
+  // Queue of all the objects of this window on the shared connection.
+  wl_event_queue* wl_event_queue_ = nullptr;
+  wl_registry* wl_registry_ = nullptr;
   wl_compositor* wl_compositor_;
   wl_seat* wl_seat_;
   wl_output* wl_output_;
@@ -160,12 +227,40 @@ class ELinuxWindowWayland : public ELinuxWindow, public WindowBindingHandler {
   zwp_text_input_v1* zwp_text_input_v1_;
   zwp_text_input_v3* zwp_text_input_v3_;
 
+  // Text around the cursor of the edited text, already bounded by the text
+  // input plugin. The offsets are in bytes.
+  std::string surrounding_text_;
+  size_t surrounding_text_cursor_ = 0;
+  size_t surrounding_text_anchor_ = 0;
+
+  // text-input-unstable-v3 changes, which are applied on the done event.
+  std::string pending_commit_string_;
+  uint32_t pending_delete_before_length_ = 0;
+  uint32_t pending_delete_after_length_ = 0;
+
   // Frame information for Vsync events.
   wp_presentation* wp_presentation_;
   uint32_t wp_presentation_clk_id_;
   uint64_t last_frame_time_nanos_;
   int32_t frame_rate_;
 
+  // Fractional scaling. The buffer is rendered at the preferred scale, and
+  // the viewport maps it back to the surface size, which is the window size.
+  wp_viewporter* wp_viewporter_ = nullptr;
+  wp_fractional_scale_manager_v1* wp_fractional_scale_manager_v1_ = nullptr;
+  wp_viewport* wp_viewport_ = nullptr;
+  wp_fractional_scale_v1* wp_fractional_scale_v1_ = nullptr;
+#if defined(USE_WAYLAND_DMABUF)
+  // Allocates the window's buffers instead of EGL. Bound only with the dmabuf
+  // feedback (version 4).
+  zwp_linux_dmabuf_v1* zwp_linux_dmabuf_v1_ = nullptr;
+#endif
+  // Ratio of the buffer size to the surface size.
+  double buffer_scale_ = 1.0;
+  // Current mode of the output in pixels, in the view orientation.
+  int32_t output_width_ = 0;
+  int32_t output_height_ = 0;
+
   CursorInfo cursor_info_;
 
   // List of cursor name and wl_cursor supported by Wayland.
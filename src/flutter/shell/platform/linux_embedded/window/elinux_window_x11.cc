@@ -121,6 +121,13 @@ bool ELinuxWindowX11::DispatchEvent() {
   return true;
 }
 
+std::vector<int> ELinuxWindowX11::GetPollFds() const {
+  if (!display_) {
+    return {};
+  }
+  return {ConnectionNumber(display_)};
+}
+
 bool ELinuxWindowX11::CreateRenderSurface(int32_t width, int32_t height) {
   auto context_egl =
       std::make_unique<ContextEgl>(std::make_unique<EnvironmentEgl>(display_));
@@ -159,6 +166,11 @@ uint16_t ELinuxWindowX11::GetRotationDegree() const {
   return current_rotation_;
 }
 
+bool ELinuxWindowX11::IsRotationAppliedByDisplay() const {
+  // X11 windows can't be rotated by the display server.
+  return false;
+}
+
 double ELinuxWindowX11::GetDpiScale() {
   return current_scale_;
 }
@@ -179,6 +191,13 @@ void ELinuxWindowX11::UpdateVirtualKeyboardStatus(const bool show) {
   // currently not supported.
 }
 
+void ELinuxWindowX11::UpdateVirtualKeyboardSurroundingText(
+    const std::string& text,
+    size_t cursor,
+    size_t anchor) {
+  // currently not supported.
+}
+
 std::string ELinuxWindowX11::GetClipboardData() {
   return clipboard_data_;
 }
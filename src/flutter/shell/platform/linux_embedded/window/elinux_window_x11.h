@@ -6,6 +6,7 @@
 #define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_WINDOW_ELINUX_WINDOW_X11_H_
 
 #include <memory>
+#include <vector>
 
 #include "flutter/shell/platform/linux_embedded/surface/surface_gl.h"
 #include "flutter/shell/platform/linux_embedded/window/elinux_window.h"
@@ -25,6 +26,9 @@ class ELinuxWindowX11 : public ELinuxWindow, public WindowBindingHandler {
   // |FlutterWindowBindingHandler|
   bool DispatchEvent() override;
 
+  // |FlutterWindowBindingHandler|
+  std::vector<int> GetPollFds() const override;
+
   // |FlutterWindowBindingHandler|
   bool CreateRenderSurface(int32_t width, int32_t height) override;
 
@@ -40,6 +44,9 @@ class ELinuxWindowX11 : public ELinuxWindow, public WindowBindingHandler {
   // |FlutterWindowBindingHandler|
   uint16_t GetRotationDegree() const override;
 
+  // |FlutterWindowBindingHandler|
+  bool IsRotationAppliedByDisplay() const override;
+
   // |FlutterWindowBindingHandler|
   double GetDpiScale() override;
 
@@ -55,6 +62,11 @@ class ELinuxWindowX11 : public ELinuxWindow, public WindowBindingHandler {
   // |FlutterWindowBindingHandler|
   void UpdateVirtualKeyboardStatus(const bool show) override;
 
+  // |FlutterWindowBindingHandler|
+  void UpdateVirtualKeyboardSurroundingText(const std::string& text,
+                                            size_t cursor,
+                                            size_t anchor) override;
+
   // |FlutterWindowBindingHandler|
   std::string GetClipboardData() override;
 
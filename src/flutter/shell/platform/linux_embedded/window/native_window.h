@@ -46,8 +46,18 @@ class NativeWindow {
 
   virtual bool Resize(const size_t width, const size_t height) = 0;
 
+  // Returns the framebuffer object which the next frame is rendered into, or
+  // 0 for the on-screen EGL surface. This is called on the raster thread with
+  // the on-screen context current.
+  virtual uint32_t Framebuffer() { return 0; }
+
+  // Returns true if the frames are rendered into Framebuffer(), and
+  // SwapBuffers() presents them without swapping the on-screen EGL surface.
+  virtual bool RendersToFramebuffer() const { return false; }
+
   // Swaps frame buffers. This API performs processing only for the DRM-GBM
-  // backend. It is prepared to make the interface common.
+  // backend and the Wayland dmabuf window. It is prepared to make the
+  // interface common.
   virtual void SwapBuffers(){/* do nothing. */};
 
  protected:
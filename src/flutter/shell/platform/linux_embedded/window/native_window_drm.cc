@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <xf86drm.h>
 
+#include <cstring>
 #include <unordered_map>
 
 #include "flutter/shell/platform/linux_embedded/logger.h"
@@ -15,6 +16,38 @@
 
 namespace flutter {
 
+namespace {
+constexpr int32_t kDefaultFrameRate = 60000;
+
+// Reads the vertical rate range from the display range limits descriptor of
+// the EDID base block.
+bool ReadVerticalRateRange(const uint8_t* edid,
+                           size_t size,
+                           uint32_t* min_rate,
+                           uint32_t* max_rate) {
+  constexpr size_t kEdidBlockSize = 128;
+  constexpr size_t kDescriptorOffset = 54;
+  constexpr size_t kDescriptorSize = 18;
+  constexpr uint8_t kRangeLimitsTag = 0xfd;
+  if (size < kEdidBlockSize) {
+    return false;
+  }
+  for (size_t offset = kDescriptorOffset; offset + kDescriptorSize <= 126;
+       offset += kDescriptorSize) {
+    auto* descriptor = edid + offset;
+    if (descriptor[0] != 0 || descriptor[1] != 0 ||
+        descriptor[3] != kRangeLimitsTag) {
+      continue;
+    }
+    // The flags in byte 4 add 255 Hz to the minimum and the maximum rates.
+    *min_rate = descriptor[5] + ((descriptor[4] & 0x1) ? 255 : 0);
+    *max_rate = descriptor[6] + ((descriptor[4] & 0x2) ? 255 : 0);
+    return *max_rate > 0;
+  }
+  return false;
+}
+}  // namespace
+
 NativeWindowDrm::NativeWindowDrm(const char* device_filename,
                                  const uint16_t rotation) {
   drm_device_ = open(device_filename, O_RDWR | O_CLOEXEC);
@@ -23,7 +56,7 @@ NativeWindowDrm::NativeWindowDrm(const char* device_filename,
     return;
   }
 
-  if (!ConfigureDisplay(rotation)) {
+  if (!ConfigureDisplay(rotation, 0)) {
     return;
   }
 
@@ -36,6 +69,22 @@ NativeWindowDrm::~NativeWindowDrm() {
   }
 }
 
+int32_t NativeWindowDrm::GetFrameRate() const {
+  if (IsVariableRefreshRateEnabled() && vrr_max_refresh_rate_ > 0) {
+    return vrr_max_refresh_rate_ * 1000;
+  }
+  if (drm_mode_info_.htotal == 0 || drm_mode_info_.vtotal == 0) {
+    return kDefaultFrameRate;
+  }
+  // The pixel clock is in kHz.
+  uint64_t pixels_per_frame =
+      static_cast<uint64_t>(drm_mode_info_.htotal) * drm_mode_info_.vtotal;
+  return static_cast<int32_t>(
+      (static_cast<uint64_t>(drm_mode_info_.clock) * 1000000 +
+       pixels_per_frame / 2) /
+      pixels_per_frame);
+}
+
 bool NativeWindowDrm::MoveCursor(double x, double y) {
   auto result =
       drmModeMoveCursor(drm_device_, drm_crtc_->crtc_id,
@@ -47,19 +96,47 @@ bool NativeWindowDrm::MoveCursor(double x, double y) {
   return true;
 }
 
-bool NativeWindowDrm::ConfigureDisplay(const uint16_t rotation) {
+bool NativeWindowDrm::SetDisplayPower(bool on) {
+  auto property = FindProperty(drm_connector_id_, DRM_MODE_OBJECT_CONNECTOR,
+                               "DPMS", nullptr);
+  if (!property) {
+    ELINUX_LOG(ERROR) << "Couldn't find the DPMS property";
+    return false;
+  }
+
+  auto result = drmModeConnectorSetProperty(
+      drm_device_, drm_connector_id_, property->prop_id,
+      on ? DRM_MODE_DPMS_ON : DRM_MODE_DPMS_OFF);
+  drmModeFreeProperty(property);
+  if (result != 0) {
+    ELINUX_LOG(ERROR) << "Couldn't set DPMS " << (on ? "on" : "off") << ": "
+                      << result;
+    return false;
+  }
+  display_power_on_ = on;
+  return true;
+}
+
+bool NativeWindowDrm::ConfigureDisplay(const uint16_t rotation,
+                                       const uint32_t changed_connector_id) {
   auto resources = drmModeGetResources(drm_device_);
   if (!resources) {
     ELINUX_LOG(ERROR) << "Couldn't get resources";
     return false;
   }
 
-  auto connector = FindConnector(resources);
+  auto connector = FindConnector(resources, changed_connector_id);
   if (!connector) {
     ELINUX_LOG(ERROR) << "Couldn't find any connectors";
     drmModeFreeResources(resources);
     return false;
   }
+  if (connector->count_modes == 0) {
+    ELINUX_LOG(ERROR) << "The connector has no modes";
+    drmModeFreeConnector(connector);
+    drmModeFreeResources(resources);
+    return false;
+  }
 
   drm_connector_id_ = connector->connector_id;
   drm_mode_info_ = connector->modes[0];
@@ -77,6 +154,10 @@ bool NativeWindowDrm::ConfigureDisplay(const uint16_t rotation) {
     drmModeFreeResources(resources);
     return false;
   }
+  // The variable refresh rate is a property of the CRTC, and its range
+  // depends on the panel, so it's set up again for the new display.
+  auto variable_refresh_rate = IsVariableRefreshRateEnabled();
+  ResetVariableRefreshRate();
   if (encoder->crtc_id) {
     drm_crtc_ = drmModeGetCrtc(drm_device_, encoder->crtc_id);
   }
@@ -85,14 +166,61 @@ bool NativeWindowDrm::ConfigureDisplay(const uint16_t rotation) {
   drmModeFreeConnector(connector);
   drmModeFreeResources(resources);
 
+  if (variable_refresh_rate) {
+    EnableVariableRefreshRate();
+  }
   return true;
 }
 
-drmModeConnectorPtr NativeWindowDrm::FindConnector(drmModeResPtr resources) {
+drmModeConnectorPtr NativeWindowDrm::FindConnector(
+    drmModeResPtr resources,
+    const uint32_t changed_connector_id) {
+  drmModeConnectorPtr found = nullptr;
   for (int i = 0; i < resources->count_connectors; i++) {
-    auto connector = drmModeGetConnector(drm_device_, resources->connectors[i]);
+    auto connector_id = resources->connectors[i];
+    auto connector = drmModeGetConnectorCurrent(drm_device_, connector_id);
+    if (!connector) {
+      continue;
+    }
+
+    // The kernel keeps the mode list of the last probe, which is stale if the
+    // connector has been plugged since then.
+    auto state = connector_states_.find(connector_id);
+    auto changed = connector_id == changed_connector_id ||
+                   (state != connector_states_.end() &&
+                    state->second != connector->connection);
+    if (connector->connection == DRM_MODE_CONNECTED &&
+        (changed || connector->count_modes == 0)) {
+      drmModeFreeConnector(connector);
+      connector = drmModeGetConnector(drm_device_, connector_id);
+      if (!connector) {
+        continue;
+      }
+    }
+    connector_states_[connector_id] = connector->connection;
+
     // pick the first connected connector
-    if (connector->connection == DRM_MODE_CONNECTED) {
+    if (!found && connector->connection == DRM_MODE_CONNECTED &&
+        connector->count_modes > 0) {
+      found = connector;
+    } else {
+      drmModeFreeConnector(connector);
+    }
+  }
+  if (found) {
+    return found;
+  }
+
+  // The status of connectors which have never been probed is unknown, so
+  // probe all of them before giving up.
+  for (int i = 0; i < resources->count_connectors; i++) {
+    auto connector = drmModeGetConnector(drm_device_, resources->connectors[i]);
+    if (!connector) {
+      continue;
+    }
+    connector_states_[connector->connector_id] = connector->connection;
+    if (connector->connection == DRM_MODE_CONNECTED &&
+        connector->count_modes > 0) {
       return connector;
     }
     drmModeFreeConnector(connector);
@@ -110,6 +238,268 @@ drmModeEncoder* NativeWindowDrm::FindEncoder(drmModeRes* resources,
   return nullptr;
 }
 
+drmModePropertyPtr NativeWindowDrm::FindProperty(uint32_t object_id,
+                                                 uint32_t object_type,
+                                                 const char* name,
+                                                 uint64_t* value) {
+  auto properties =
+      drmModeObjectGetProperties(drm_device_, object_id, object_type);
+  if (!properties) {
+    return nullptr;
+  }
+
+  drmModePropertyPtr found = nullptr;
+  for (uint32_t i = 0; i < properties->count_props; i++) {
+    auto property = drmModeGetProperty(drm_device_, properties->props[i]);
+    if (!property) {
+      continue;
+    }
+    if (std::strcmp(property->name, name) == 0) {
+      found = property;
+      if (value) {
+        *value = properties->prop_values[i];
+      }
+      break;
+    }
+    drmModeFreeProperty(property);
+  }
+  drmModeFreeObjectProperties(properties);
+  return found;
+}
+
+uint32_t NativeWindowDrm::FindPrimaryPlane() {
+  if (!drm_crtc_) {
+    return 0;
+  }
+
+  // The primary plane is only exposed to clients with this capability.
+  if (drmSetClientCap(drm_device_, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0) {
+    ELINUX_LOG(WARNING) << "Couldn't set DRM_CLIENT_CAP_UNIVERSAL_PLANES";
+    return 0;
+  }
+
+  auto plane_resources = drmModeGetPlaneResources(drm_device_);
+  if (!plane_resources) {
+    ELINUX_LOG(WARNING) << "Couldn't get plane resources";
+    return 0;
+  }
+  uint32_t plane_id = 0;
+  for (uint32_t i = 0; i < plane_resources->count_planes && !plane_id; i++) {
+    auto plane = drmModeGetPlane(drm_device_, plane_resources->planes[i]);
+    if (!plane) {
+      continue;
+    }
+    auto is_on_crtc = plane->crtc_id == drm_crtc_->crtc_id;
+    drmModeFreePlane(plane);
+    if (!is_on_crtc) {
+      continue;
+    }
+
+    uint64_t type = 0;
+    auto property = FindProperty(plane_resources->planes[i],
+                                 DRM_MODE_OBJECT_PLANE, "type", &type);
+    if (property) {
+      drmModeFreeProperty(property);
+      if (type == DRM_PLANE_TYPE_PRIMARY) {
+        plane_id = plane_resources->planes[i];
+      }
+    }
+  }
+  drmModeFreePlaneResources(plane_resources);
+  return plane_id;
+}
+
+std::vector<uint64_t> NativeWindowDrm::GetScanoutModifiers(uint32_t format) {
+  std::vector<uint64_t> modifiers;
+  auto plane_id = FindPrimaryPlane();
+  if (!plane_id) {
+    return modifiers;
+  }
+
+  uint64_t blob_id = 0;
+  auto property =
+      FindProperty(plane_id, DRM_MODE_OBJECT_PLANE, "IN_FORMATS", &blob_id);
+  if (!property) {
+    return modifiers;
+  }
+  drmModeFreeProperty(property);
+  auto blob = blob_id ? drmModeGetPropertyBlob(drm_device_, blob_id) : nullptr;
+  if (!blob) {
+    return modifiers;
+  }
+  if (blob->length < sizeof(drm_format_modifier_blob)) {
+    drmModeFreePropertyBlob(blob);
+    return modifiers;
+  }
+
+  auto* data = static_cast<const uint8_t*>(blob->data);
+  auto* header = reinterpret_cast<const drm_format_modifier_blob*>(data);
+  auto* formats =
+      reinterpret_cast<const uint32_t*>(data + header->formats_offset);
+  auto* entries = reinterpret_cast<const drm_format_modifier*>(
+      data + header->modifiers_offset);
+  for (uint32_t i = 0; i < header->count_formats; i++) {
+    if (formats[i] != format) {
+      continue;
+    }
+    // Each entry covers 64 formats from |offset| with a bitmask.
+    for (uint32_t j = 0; j < header->count_modifiers; j++) {
+      auto& entry = entries[j];
+      if (i >= entry.offset && i < entry.offset + 64 &&
+          (entry.formats & (1ULL << (i - entry.offset)))) {
+        modifiers.push_back(entry.modifier);
+      }
+    }
+    break;
+  }
+  drmModeFreePropertyBlob(blob);
+  return modifiers;
+}
+
+bool NativeWindowDrm::SetPlaneRotation(const uint16_t rotation) {
+  if (!drm_crtc_) {
+    return false;
+  }
+
+  // The view rotation is clockwise, whereas KMS rotates counter-clockwise.
+  const char* rotation_name = "rotate-0";
+  if (rotation == 90) {
+    rotation_name = "rotate-270";
+  } else if (rotation == 180) {
+    rotation_name = "rotate-180";
+  } else if (rotation == 270) {
+    rotation_name = "rotate-90";
+  }
+
+  auto plane_id = FindPrimaryPlane();
+  if (!plane_id) {
+    ELINUX_LOG(WARNING) << "Couldn't find the primary plane";
+    return false;
+  }
+
+  uint64_t initial_rotation = 0;
+  auto property = FindProperty(plane_id, DRM_MODE_OBJECT_PLANE, "rotation",
+                               &initial_rotation);
+  if (!property) {
+    ELINUX_LOG(WARNING) << "The primary plane doesn't support rotation";
+    return false;
+  }
+  // "rotation" is a bitmask property: the enum values are bit positions.
+  int result = -1;
+  for (int i = 0; i < property->count_enums; i++) {
+    if (std::strcmp(property->enums[i].name, rotation_name) == 0) {
+      result = drmModeObjectSetProperty(drm_device_, plane_id,
+                                        DRM_MODE_OBJECT_PLANE,
+                                        property->prop_id,
+                                        1ULL << property->enums[i].value);
+      break;
+    }
+  }
+  auto property_id = property->prop_id;
+  drmModeFreeProperty(property);
+  if (result != 0) {
+    ELINUX_LOG(WARNING) << "The primary plane doesn't support "
+                        << rotation_name;
+    return false;
+  }
+
+  rotated_plane_id_ = plane_id;
+  rotation_property_id_ = property_id;
+  initial_plane_rotation_ = initial_rotation;
+  ELINUX_LOG(INFO) << "The primary plane is rotated: " << rotation_name;
+  return true;
+}
+
+void NativeWindowDrm::ResetPlaneRotation() {
+  if (!rotated_plane_id_) {
+    return;
+  }
+  if (drmModeObjectSetProperty(drm_device_, rotated_plane_id_,
+                               DRM_MODE_OBJECT_PLANE, rotation_property_id_,
+                               initial_plane_rotation_) != 0) {
+    ELINUX_LOG(WARNING) << "Couldn't restore the primary plane rotation";
+  }
+  rotated_plane_id_ = 0;
+}
+
+bool NativeWindowDrm::EnableVariableRefreshRate() {
+  if (!drm_crtc_) {
+    return false;
+  }
+
+  uint64_t capable = 0;
+  auto property = FindProperty(drm_connector_id_, DRM_MODE_OBJECT_CONNECTOR,
+                               "vrr_capable", &capable);
+  if (!property) {
+    ELINUX_LOG(WARNING)
+        << "The connector doesn't support variable refresh rate";
+    return false;
+  }
+  drmModeFreeProperty(property);
+  if (!capable) {
+    ELINUX_LOG(WARNING) << "The display isn't capable of variable refresh rate";
+    return false;
+  }
+
+  property = FindProperty(drm_crtc_->crtc_id, DRM_MODE_OBJECT_CRTC,
+                          "VRR_ENABLED", nullptr);
+  if (!property) {
+    ELINUX_LOG(WARNING) << "The CRTC doesn't support variable refresh rate";
+    return false;
+  }
+  auto property_id = property->prop_id;
+  drmModeFreeProperty(property);
+  // On atomic drivers, the kernel applies this with an atomic commit on the
+  // CRTC.
+  auto result = drmModeObjectSetProperty(drm_device_, drm_crtc_->crtc_id,
+                                         DRM_MODE_OBJECT_CRTC, property_id, 1);
+  if (result != 0) {
+    ELINUX_LOG(WARNING) << "Couldn't enable variable refresh rate: " << result;
+    return false;
+  }
+  vrr_property_id_ = property_id;
+
+  vrr_min_refresh_rate_ = 0;
+  vrr_max_refresh_rate_ = 0;
+  uint64_t edid_blob_id = 0;
+  property = FindProperty(drm_connector_id_, DRM_MODE_OBJECT_CONNECTOR, "EDID",
+                          &edid_blob_id);
+  if (property) {
+    drmModeFreeProperty(property);
+    auto blob = edid_blob_id
+                    ? drmModeGetPropertyBlob(drm_device_, edid_blob_id)
+                    : nullptr;
+    if (blob) {
+      ReadVerticalRateRange(static_cast<const uint8_t*>(blob->data),
+                            blob->length, &vrr_min_refresh_rate_,
+                            &vrr_max_refresh_rate_);
+      drmModeFreePropertyBlob(blob);
+    }
+  }
+  // The refresh cycle can't be shorter than the one of the mode.
+  auto mode_rate = static_cast<uint32_t>(drm_mode_info_.vrefresh);
+  if (mode_rate > 0 && (vrr_max_refresh_rate_ == 0 ||
+                        vrr_max_refresh_rate_ > mode_rate)) {
+    vrr_max_refresh_rate_ = mode_rate;
+  }
+  ELINUX_LOG(INFO) << "Variable refresh rate is enabled: "
+                   << vrr_min_refresh_rate_ << "-" << vrr_max_refresh_rate_
+                   << " Hz";
+  return true;
+}
+
+void NativeWindowDrm::ResetVariableRefreshRate() {
+  if (!vrr_property_id_) {
+    return;
+  }
+  if (drmModeObjectSetProperty(drm_device_, drm_crtc_->crtc_id,
+                               DRM_MODE_OBJECT_CRTC, vrr_property_id_,
+                               0) != 0) {
+    ELINUX_LOG(WARNING) << "Couldn't disable variable refresh rate";
+  }
+  vrr_property_id_ = 0;
+}
+
 const uint32_t* NativeWindowDrm::GetCursorData(const std::string& cursor_name) {
   // const uint32_t* NativeWindowDrm::GetCursorData(const std::string&
   // cursor_name) { If there is no cursor data corresponding to the Flutter's
@@ -7,7 +7,10 @@
 
 #include <xf86drmMode.h>
 
+#include <atomic>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "flutter/shell/platform/linux_embedded/surface/surface_gl.h"
 #include "flutter/shell/platform/linux_embedded/window/native_window.h"
@@ -19,10 +22,33 @@ class NativeWindowDrm : public NativeWindow {
   NativeWindowDrm(const char* device_filename, const uint16_t rotation);
   virtual ~NativeWindowDrm();
 
-  bool ConfigureDisplay(const uint16_t rotation);
+  // Picks the connector and the mode to display. |changed_connector_id| is
+  // the connector reported by a hotplug event, or 0 if it's unknown. If the
+  // variable refresh rate is enabled, it's enabled again for the new display,
+  // which may change GetFrameRate().
+  bool ConfigureDisplay(const uint16_t rotation,
+                        const uint32_t changed_connector_id);
 
   bool MoveCursor(double x, double y);
 
+  // Turns the display on or off with the DPMS property of the connector. The
+  // render surface and the CRTC configuration are kept as they are, so the
+  // display can be restored immediately.
+  bool SetDisplayPower(bool on);
+
+  bool IsDisplayPowerOn() const { return display_power_on_; }
+
+  // Returns true if the primary plane rotates the frames for the display, so
+  // they are rendered unrotated in the view size.
+  bool IsPlaneRotationEnabled() const { return rotated_plane_id_ != 0; }
+
+  // Returns true if the CRTC scans out at a variable refresh rate.
+  bool IsVariableRefreshRateEnabled() const { return vrr_property_id_ != 0; }
+
+  // Returns the refresh rate of the display in mHz. With a variable refresh
+  // rate, this is the highest rate of the panel's range.
+  int32_t GetFrameRate() const;
+
   virtual bool ShowCursor(double x, double y) = 0;
 
   virtual bool UpdateCursor(const std::string& cursor_name,
@@ -34,11 +60,48 @@ class NativeWindowDrm : public NativeWindow {
   virtual std::unique_ptr<SurfaceGl> CreateRenderSurface() = 0;
 
  protected:
-  drmModeConnectorPtr FindConnector(drmModeResPtr resources);
+  // Returns the first connected connector. The connectors are read from the
+  // kernel's state without probing them, which reads the EDID and can take a
+  // long time. Only the connectors which have changed or have no modes yet
+  // are probed.
+  drmModeConnectorPtr FindConnector(drmModeResPtr resources,
+                                    const uint32_t changed_connector_id);
 
   drmModeEncoder* FindEncoder(drmModeRes* resources,
                               drmModeConnector* connector);
 
+  // Finds the property named |name| of a DRM object. The returned property
+  // must be freed with drmModeFreeProperty().
+  drmModePropertyPtr FindProperty(uint32_t object_id,
+                                  uint32_t object_type,
+                                  const char* name,
+                                  uint64_t* value);
+
+  // Returns the primary plane of the CRTC, or 0 if it's not found.
+  uint32_t FindPrimaryPlane();
+
+  // Returns the modifiers of |format| (DRM fourcc) which the primary plane
+  // can scan out. Empty if the plane doesn't advertise them, in which case
+  // only the implicit (or linear) layout is known to work.
+  std::vector<uint64_t> GetScanoutModifiers(uint32_t format);
+
+  // Rotates the primary plane of the CRTC by |rotation| (degree, clockwise)
+  // with its "rotation" property. Returns false if the plane doesn't support
+  // it, in which case the frames must be rotated by the GPU.
+  bool SetPlaneRotation(const uint16_t rotation);
+
+  // Restores the rotation of the primary plane changed by SetPlaneRotation().
+  void ResetPlaneRotation();
+
+  // Sets the "VRR_ENABLED" property of the CRTC if the connector is
+  // "vrr_capable". The refresh cycle then lasts until the next frame is
+  // flipped, within the range of the panel. Returns false if it's not
+  // supported.
+  bool EnableVariableRefreshRate();
+
+  // Restores the refresh rate changed by EnableVariableRefreshRate().
+  void ResetVariableRefreshRate();
+
   // Convert Flutter's cursor value to cursor data.
   const uint32_t* GetCursorData(const std::string& cursor_name);
 
@@ -47,6 +110,21 @@ class NativeWindowDrm : public NativeWindow {
   drmModeCrtc* drm_crtc_ = nullptr;
   drmModeModeInfo drm_mode_info_;
 
+  // Read from the raster thread when presenting frames.
+  std::atomic<bool> display_power_on_ = true;
+
+  uint32_t rotated_plane_id_ = 0;
+  uint32_t rotation_property_id_ = 0;
+  uint64_t initial_plane_rotation_ = 0;
+
+  uint32_t vrr_property_id_ = 0;
+  // The vertical refresh range in Hz read from the EDID, or 0 if unknown.
+  uint32_t vrr_min_refresh_rate_ = 0;
+  uint32_t vrr_max_refresh_rate_ = 0;
+
+  // The connection status of each connector when it was last read.
+  std::unordered_map<uint32_t, drmModeConnection> connector_states_;
+
   std::string cursor_name_ = "";
   std::pair<int32_t, int32_t> cursor_hotspot_ = {0, 0};
 };
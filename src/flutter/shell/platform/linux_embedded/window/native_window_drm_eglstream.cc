@@ -18,15 +18,29 @@ namespace {
 constexpr char kCursorNameNone[] = "none";
 }  // namespace
 
-NativeWindowDrmEglstream::NativeWindowDrmEglstream(const char* device_filename,
-                                                   const uint16_t rotation)
+NativeWindowDrmEglstream::NativeWindowDrmEglstream(
+    const char* device_filename,
+    const uint16_t rotation,
+    const bool use_display_rotation,
+    const bool use_variable_refresh_rate)
     : NativeWindowDrm(device_filename, rotation) {
   if (!valid_) {
     return;
   }
 
+  if (use_display_rotation && rotation != 0) {
+    // The EGLStream output always has the mode size, so the plane can't be
+    // rotated.
+    ELINUX_LOG(WARNING) << "Display rotation isn't supported with EGLStream, "
+                           "the frames are rotated by the GPU.";
+  }
+
   valid_ = ConfigureDisplayAdditional();
 
+  if (valid_ && use_variable_refresh_rate) {
+    EnableVariableRefreshRate();
+  }
+
   // drmIsMaster() is a relatively new API, and the main target of EGLStream is
   // NVIDIA devices. Currently, NVIDIA devices' libdrm is a bit older.
   // drmIsMaster() may not exist. However, according to NVIDA's API document,
@@ -42,6 +56,8 @@ NativeWindowDrmEglstream::~NativeWindowDrmEglstream() {
     return;
   }
 
+  ResetVariableRefreshRate();
+
   if (drm_crtc_) {
     drmModeSetCrtc(drm_device_, drm_crtc_->crtc_id, drm_crtc_->buffer_id,
                    drm_crtc_->x, drm_crtc_->y, &drm_connector_id_, 1,
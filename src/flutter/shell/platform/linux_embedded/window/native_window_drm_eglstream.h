@@ -17,7 +17,9 @@ namespace flutter {
 class NativeWindowDrmEglstream : public NativeWindowDrm {
  public:
   NativeWindowDrmEglstream(const char* device_filename,
-                           const uint16_t rotation);
+                           const uint16_t rotation,
+                           const bool use_display_rotation,
+                           const bool use_variable_refresh_rate);
   ~NativeWindowDrmEglstream();
 
   // |NativeWindowDrm|
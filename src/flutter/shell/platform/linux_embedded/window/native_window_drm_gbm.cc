@@ -4,6 +4,15 @@
 
 #include "flutter/shell/platform/linux_embedded/window/native_window_drm_gbm.h"
 
+#include <drm_fourcc.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include "flutter/shell/platform/linux_embedded/logger.h"
 #include "flutter/shell/platform/linux_embedded/surface/context_egl.h"
 #include "flutter/shell/platform/linux_embedded/surface/cursor_data.h"
@@ -13,14 +22,25 @@ namespace flutter {
 namespace {
 constexpr char kCursorNameNone[] = "none";
 
+// The render node of the GPU, when it's a different device from the display
+// controller given by FLUTTER_DRM_DEVICE.
+constexpr char kFlutterDrmRenderDeviceEnvironmentKey[] =
+    "FLUTTER_DRM_RENDER_DEVICE";
+
 // Buffer size for cursor image. The size must be at least 64x64 due to the
 // restrictions of drmModeSetCursor API.
 constexpr uint32_t kCursorBufferWidth = 64;
 constexpr uint32_t kCursorBufferHeight = 64;
+
+// Upper limit of the wait for a page flip, which is far longer than the
+// refresh cycle of any display.
+constexpr int kPageFlipTimeoutMs = 1000;
 }  // namespace
 
 NativeWindowDrmGbm::NativeWindowDrmGbm(const char* device_filename,
-                                       const uint16_t rotation)
+                                       const uint16_t rotation,
+                                       const bool use_display_rotation,
+                                       const bool use_variable_refresh_rate)
     : NativeWindowDrm(device_filename, rotation) {
   if (!valid_) {
     return;
@@ -34,13 +54,31 @@ NativeWindowDrmGbm::NativeWindowDrmGbm(const char* device_filename,
     return;
   }
 
-  gbm_device_ = gbm_create_device(drm_device_);
-  if (!gbm_device_) {
+  if (!OpenRenderDevice()) {
+    valid_ = false;
+    return;
+  }
+
+  if (render_device_ != -1) {
+    gbm_device_ = gbm_create_device(render_device_);
+    gbm_display_device_ = gbm_create_device(drm_device_);
+  } else {
+    gbm_device_ = gbm_create_device(drm_device_);
+  }
+  if (!gbm_device_ || (render_device_ != -1 && !gbm_display_device_)) {
     ELINUX_LOG(ERROR) << "Couldn't create the GBM device.";
     valid_ = false;
     return;
   }
 
+  if (use_display_rotation && rotation != 0) {
+    SetPlaneRotation(rotation);
+  }
+
+  if (use_variable_refresh_rate) {
+    EnableVariableRefreshRate();
+  }
+
   CreateGbmSurface();
 }
 
@@ -54,6 +92,9 @@ NativeWindowDrmGbm::~NativeWindowDrmGbm() {
     gbm_cursor_bo_ = nullptr;
   }
 
+  ResetPlaneRotation();
+  ResetVariableRefreshRate();
+
   if (drm_crtc_) {
     drmModeSetCrtc(drm_device_, drm_crtc_->crtc_id, drm_crtc_->buffer_id,
                    drm_crtc_->x, drm_crtc_->y, &drm_connector_id_, 1,
@@ -75,6 +116,12 @@ NativeWindowDrmGbm::~NativeWindowDrmGbm() {
   if (gbm_device_) {
     gbm_device_destroy(gbm_device_);
   }
+  if (gbm_display_device_) {
+    gbm_device_destroy(gbm_display_device_);
+  }
+  if (render_device_ != -1) {
+    close(render_device_);
+  }
 }
 
 bool NativeWindowDrmGbm::ShowCursor(double x, double y) {
@@ -165,20 +212,28 @@ bool NativeWindowDrmGbm::Resize(const size_t width, const size_t height) {
 
 void NativeWindowDrmGbm::SwapBuffers() {
   auto* bo = gbm_surface_lock_front_buffer(static_cast<gbm_surface*>(window_));
-  auto width = gbm_bo_get_width(bo);
-  auto height = gbm_bo_get_height(bo);
-  auto handle = gbm_bo_get_handle(bo).u32;
-  auto stride = gbm_bo_get_stride(bo);
-  uint32_t fb;
-  int result =
-      drmModeAddFB(drm_device_, width, height, 24, 32, stride, handle, &fb);
-  if (result != 0) {
-    ELINUX_LOG(ERROR) << "Failed to add a framebuffer. (" << result << ")";
+  // Setting the CRTC implicitly turns the display back on, so frames which
+  // are still produced while the display is blanked aren't scanned out. The
+  // CRTC keeps the framebuffer of the last frame until then, so that one
+  // stays alive and the new frame is dropped.
+  if (!display_power_on_ && gbm_previous_bo_) {
+    gbm_surface_release_buffer(static_cast<gbm_surface*>(window_), bo);
+    return;
   }
-  result = drmModeSetCrtc(drm_device_, drm_crtc_->crtc_id, fb, 0, 0,
-                          &drm_connector_id_, 1, &drm_mode_info_);
-  if (result != 0) {
-    ELINUX_LOG(ERROR) << "Failed to set crct mode. (" << result << ")";
+
+  uint32_t fb = 0;
+  AddFramebuffer(bo, &fb);
+  // A full mode set holds the refresh cycle of the mode, so the frames are
+  // flipped instead when the refresh rate follows them.
+  if (display_power_on_ &&
+      !(IsVariableRefreshRateEnabled() && crtc_configured_ && PageFlip(fb))) {
+    auto result = drmModeSetCrtc(drm_device_, drm_crtc_->crtc_id, fb, 0, 0,
+                                 &drm_connector_id_, 1, &drm_mode_info_);
+    if (result != 0) {
+      ELINUX_LOG(ERROR) << "Failed to set crct mode. (" << result << ")";
+    } else {
+      crtc_configured_ = true;
+    }
   }
 
   if (gbm_previous_bo_) {
@@ -190,10 +245,107 @@ void NativeWindowDrmGbm::SwapBuffers() {
   gbm_previous_fb_ = fb;
 }
 
+bool NativeWindowDrmGbm::PageFlip(uint32_t fb) {
+  drmEventContext context = {};
+  context.version = 2;
+  context.page_flip_handler = [](int fd, unsigned int sequence,
+                                 unsigned int tv_sec, unsigned int tv_usec,
+                                 void* user_data) {
+    static_cast<NativeWindowDrmGbm*>(user_data)->page_flip_pending_ = false;
+  };
+  pollfd fds = {drm_device_, POLLIN, 0};
+  auto wait_for_flip = [&]() {
+    while (page_flip_pending_) {
+      auto result = poll(&fds, 1, kPageFlipTimeoutMs);
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result <= 0) {
+        return false;
+      }
+      drmHandleEvent(drm_device_, &context);
+    }
+    return true;
+  };
+
+  // A flip which timed out earlier has to complete before the next one.
+  if (!wait_for_flip()) {
+    ELINUX_LOG(ERROR) << "The previous page flip is still pending.";
+    return false;
+  }
+
+  auto result = drmModePageFlip(drm_device_, drm_crtc_->crtc_id, fb,
+                                DRM_MODE_PAGE_FLIP_EVENT, this);
+  if (result != 0) {
+    ELINUX_LOG(WARNING) << "Failed to flip the page. (" << result << ")";
+    return false;
+  }
+  page_flip_pending_ = true;
+
+  // The previous buffer can't be released until the flip is done. If it
+  // times out, the caller sets the mode instead, which waits for the pending
+  // flip and scans out |fb| before the previous buffer is released.
+  if (!wait_for_flip()) {
+    ELINUX_LOG(ERROR) << "Timed out waiting for the page flip.";
+    return false;
+  }
+  return true;
+}
+
+bool NativeWindowDrmGbm::OpenRenderDevice() {
+  auto device_filename = std::getenv(kFlutterDrmRenderDeviceEnvironmentKey);
+  if (!device_filename || device_filename[0] == '\0') {
+    return true;
+  }
+
+  render_device_ = open(device_filename, O_RDWR | O_CLOEXEC);
+  if (render_device_ == -1) {
+    ELINUX_LOG(ERROR) << "Couldn't open " << device_filename;
+    return false;
+  }
+
+  // The frames are shared with dmabuf, so both devices need PRIME.
+  uint64_t render_cap = 0;
+  uint64_t display_cap = 0;
+  if (drmGetCap(render_device_, DRM_CAP_PRIME, &render_cap) != 0 ||
+      !(render_cap & DRM_PRIME_CAP_EXPORT) ||
+      drmGetCap(drm_device_, DRM_CAP_PRIME, &display_cap) != 0 ||
+      !(display_cap & DRM_PRIME_CAP_IMPORT)) {
+    ELINUX_LOG(ERROR) << "The devices can't share buffers with PRIME.";
+    close(render_device_);
+    render_device_ = -1;
+    return false;
+  }
+  ELINUX_LOG(INFO) << "Render device: " << device_filename;
+  return true;
+}
+
 bool NativeWindowDrmGbm::CreateGbmSurface() {
-  window_ = gbm_surface_create(gbm_device_, drm_mode_info_.hdisplay,
-                               drm_mode_info_.vdisplay, GBM_FORMAT_ARGB8888,
-                               GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING);
+  // A rotated plane scans out the frames in the view orientation, whose size
+  // is already swapped for 90 and 270 degrees.
+  auto width = IsPlaneRotationEnabled() ? width_ : drm_mode_info_.hdisplay;
+  auto height = IsPlaneRotationEnabled() ? height_ : drm_mode_info_.vdisplay;
+  if (render_device_ == -1) {
+    window_ =
+        gbm_surface_create(gbm_device_, width, height, GBM_FORMAT_ARGB8888,
+                           GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING);
+  } else {
+    // The buffers need a layout both devices understand. The GPU picks one of
+    // the modifiers which the display can scan out, otherwise it falls back
+    // to the linear layout.
+    auto modifiers = GetScanoutModifiers(DRM_FORMAT_XRGB8888);
+    if (!modifiers.empty()) {
+      window_ = gbm_surface_create_with_modifiers(
+          gbm_device_, width, height, GBM_FORMAT_ARGB8888, modifiers.data(),
+          modifiers.size());
+    }
+    if (!window_) {
+      ELINUX_LOG(INFO) << "Use linear buffers for the display device.";
+      window_ =
+          gbm_surface_create(gbm_device_, width, height, GBM_FORMAT_ARGB8888,
+                             GBM_BO_USE_RENDERING | GBM_BO_USE_LINEAR);
+    }
+  }
   if (!window_) {
     ELINUX_LOG(ERROR) << "Failed to create the gbm surface.";
     valid_ = false;
@@ -210,9 +362,66 @@ bool NativeWindowDrmGbm::CreateGbmSurface() {
   return true;
 }
 
+bool NativeWindowDrmGbm::AddFramebuffer(gbm_bo* bo, uint32_t* fb) {
+  auto width = gbm_bo_get_width(bo);
+  auto height = gbm_bo_get_height(bo);
+  int result;
+  if (render_device_ == -1) {
+    auto handle = gbm_bo_get_handle(bo).u32;
+    auto stride = gbm_bo_get_stride(bo);
+    result =
+        drmModeAddFB(drm_device_, width, height, 24, 32, stride, handle, fb);
+    if (result != 0) {
+      ELINUX_LOG(ERROR) << "Failed to add a framebuffer. (" << result << ")";
+      return false;
+    }
+    return true;
+  }
+
+  auto prime_fd = gbm_bo_get_fd(bo);
+  if (prime_fd < 0) {
+    ELINUX_LOG(ERROR) << "Failed to export the buffer.";
+    return false;
+  }
+  uint32_t handle = 0;
+  result = drmPrimeFDToHandle(drm_device_, prime_fd, &handle);
+  close(prime_fd);
+  if (result != 0) {
+    ELINUX_LOG(ERROR) << "Failed to import the buffer. (" << result << ")";
+    return false;
+  }
+
+  uint32_t handles[4] = {};
+  uint32_t pitches[4] = {};
+  uint32_t offsets[4] = {};
+  uint64_t modifiers[4] = {};
+  auto modifier = gbm_bo_get_modifier(bo);
+  auto plane_count = std::min(gbm_bo_get_plane_count(bo), 4);
+  for (int i = 0; i < plane_count; i++) {
+    handles[i] = handle;
+    pitches[i] = gbm_bo_get_stride_for_plane(bo, i);
+    offsets[i] = gbm_bo_get_offset(bo, i);
+    modifiers[i] = modifier;
+  }
+  auto use_modifiers = modifier != DRM_FORMAT_MOD_INVALID;
+  result = drmModeAddFB2WithModifiers(
+      drm_device_, width, height, DRM_FORMAT_XRGB8888, handles, pitches,
+      offsets, use_modifiers ? modifiers : nullptr, fb,
+      use_modifiers ? DRM_MODE_FB_MODIFIERS : 0);
+  // The framebuffer holds its own reference to the buffer.
+  drm_gem_close gem_close = {};
+  gem_close.handle = handle;
+  drmIoctl(drm_device_, DRM_IOCTL_GEM_CLOSE, &gem_close);
+  if (result != 0) {
+    ELINUX_LOG(ERROR) << "Failed to add a framebuffer. (" << result << ")";
+    return false;
+  }
+  return true;
+}
+
 bool NativeWindowDrmGbm::CreateCursorBuffer(const std::string& cursor_name) {
   if (!gbm_cursor_bo_) {
-    gbm_cursor_bo_ = gbm_bo_create(gbm_device_, kCursorBufferWidth,
+    gbm_cursor_bo_ = gbm_bo_create(GetScanoutGbmDevice(), kCursorBufferWidth,
                                    kCursorBufferHeight, GBM_FORMAT_ARGB8888,
                                    GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE);
     if (!gbm_cursor_bo_) {
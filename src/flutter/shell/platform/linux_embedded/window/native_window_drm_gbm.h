@@ -17,7 +17,10 @@ namespace flutter {
 
 class NativeWindowDrmGbm : public NativeWindowDrm {
  public:
-  NativeWindowDrmGbm(const char* device_filename, const uint16_t rotation);
+  NativeWindowDrmGbm(const char* device_filename,
+                     const uint16_t rotation,
+                     const bool use_display_rotation,
+                     const bool use_variable_refresh_rate);
   ~NativeWindowDrmGbm();
 
   // |NativeWindowDrm|
@@ -44,13 +47,40 @@ class NativeWindowDrmGbm : public NativeWindowDrm {
   void SwapBuffers() override;
 
  private:
+  // Opens the render node named by FLUTTER_DRM_RENDER_DEVICE if the GPU is
+  // a separate device from the display controller.
+  bool OpenRenderDevice();
+
   bool CreateGbmSurface();
 
+  // Adds a KMS framebuffer for |bo|. A buffer of the render device is
+  // imported into the display device with PRIME.
+  bool AddFramebuffer(gbm_bo* bo, uint32_t* fb);
+
+  // Returns the device which allocates buffers for scanout, such as cursors.
+  gbm_device* GetScanoutGbmDevice() const {
+    return gbm_display_device_ ? gbm_display_device_ : gbm_device_;
+  }
+
   bool CreateCursorBuffer(const std::string& cursor_name);
 
+  // Flips the CRTC to |fb| and waits until it's scanned out. With a variable
+  // refresh rate, the display refreshes when the flip arrives. Returns false
+  // if |fb| isn't known to be scanned out, in which case the mode must be
+  // set instead.
+  bool PageFlip(uint32_t fb);
+
   gbm_bo* gbm_previous_bo_ = nullptr;
   uint32_t gbm_previous_fb_;
+  // Set once the mode is set with a framebuffer, after which frames can be
+  // presented with page flips.
+  bool crtc_configured_ = false;
+  bool page_flip_pending_ = false;
+  // Renders the frames. On the render device, if there is.
   gbm_device* gbm_device_ = nullptr;
+  // The display device, only when it's separate from the render device.
+  gbm_device* gbm_display_device_ = nullptr;
+  int render_device_ = -1;
   gbm_bo* gbm_cursor_bo_ = nullptr;
 };
 
@@ -0,0 +1,604 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/platform/linux_embedded/window/native_window_wayland_dmabuf.h"
+
+#ifdef USE_GLES3
+#include <GLES3/gl32.h>
+#else
+#include <GLES2/gl2.h>
+#endif
+#include <GLES2/gl2ext.h>
+#include <drm_fourcc.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <xf86drm.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "flutter/shell/platform/linux_embedded/logger.h"
+#include "flutter/shell/platform/linux_embedded/surface/egl_utils.h"
+
+namespace flutter {
+
+namespace {
+
+constexpr char kFallbackRenderNode[] = "/dev/dri/renderD128";
+
+// Formats in the order of preference. Both are scanned out by most display
+// controllers.
+constexpr uint32_t kPreferredFormats[] = {DRM_FORMAT_ARGB8888,
+                                          DRM_FORMAT_XRGB8888};
+
+// Enough for triple buffering while the compositor holds one buffer on the
+// screen. Past it, the raster thread waits for the compositor to release one.
+constexpr size_t kMaxBuffers = 4;
+
+// How long to wait for a buffer release before dropping the frame, e.g. when
+// the compositor stops releasing the buffers of a hidden window.
+constexpr std::chrono::milliseconds kReleaseTimeout(100);
+
+constexpr EGLint kPlaneAttributes[][5] = {
+    {EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE0_PITCH_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE1_PITCH_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE2_PITCH_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT},
+    {EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT,
+     EGL_DMA_BUF_PLANE3_PITCH_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT,
+     EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT},
+};
+
+struct EglImageProcs {
+  PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR;
+  PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR;
+  PFNGLEGLIMAGETARGETRENDERBUFFERSTORAGEOESPROC
+  glEGLImageTargetRenderbufferStorageOES;
+};
+
+const EglImageProcs& GetEglImageProcs() {
+  static const EglImageProcs procs = {
+      reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(
+          eglGetProcAddress("eglCreateImageKHR")),
+      reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(
+          eglGetProcAddress("eglDestroyImageKHR")),
+      reinterpret_cast<PFNGLEGLIMAGETARGETRENDERBUFFERSTORAGEOESPROC>(
+          eglGetProcAddress("glEGLImageTargetRenderbufferStorageOES")),
+  };
+  return procs;
+}
+
+}  // namespace
+
+const zwp_linux_dmabuf_feedback_v1_listener
+    NativeWindowWaylandDmabuf::kFeedbackListener = {
+        .done =
+            [](void* data, zwp_linux_dmabuf_feedback_v1* feedback) {
+              auto self = reinterpret_cast<NativeWindowWaylandDmabuf*>(data);
+              self->OnFeedbackDone();
+            },
+        .format_table =
+            [](void* data,
+               zwp_linux_dmabuf_feedback_v1* feedback,
+               int32_t fd,
+               uint32_t size) {
+              auto self = reinterpret_cast<NativeWindowWaylandDmabuf*>(data);
+              auto* table = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+              if (table == MAP_FAILED) {
+                ELINUX_LOG(ERROR) << "Failed to map the dmabuf format table.";
+                close(fd);
+                return;
+              }
+              auto* entries = static_cast<const FormatTableEntry*>(table);
+              self->format_table_.assign(
+                  entries, entries + size / sizeof(FormatTableEntry));
+              munmap(table, size);
+              close(fd);
+            },
+        .main_device =
+            [](void* data,
+               zwp_linux_dmabuf_feedback_v1* feedback,
+               wl_array* device) {
+              auto self = reinterpret_cast<NativeWindowWaylandDmabuf*>(data);
+              if (device->size == sizeof(dev_t)) {
+                memcpy(&self->main_device_, device->data, sizeof(dev_t));
+                self->has_main_device_ = true;
+              }
+            },
+        .tranche_done =
+            [](void* data, zwp_linux_dmabuf_feedback_v1* feedback) {
+              auto self = reinterpret_cast<NativeWindowWaylandDmabuf*>(data);
+              self->pending_tranches_.push_back(
+                  std::move(self->pending_tranche_));
+              self->pending_tranche_ = {};
+            },
+        .tranche_target_device = [](void* data,
+                                    zwp_linux_dmabuf_feedback_v1* feedback,
+                                    wl_array* device) {},
+        .tranche_formats =
+            [](void* data,
+               zwp_linux_dmabuf_feedback_v1* feedback,
+               wl_array* indices) {
+              auto self = reinterpret_cast<NativeWindowWaylandDmabuf*>(data);
+              auto* begin = static_cast<const uint16_t*>(indices->data);
+              self->pending_tranche_.indices.insert(
+                  self->pending_tranche_.indices.end(), begin,
+                  begin + indices->size / sizeof(uint16_t));
+            },
+        .tranche_flags =
+            [](void* data,
+               zwp_linux_dmabuf_feedback_v1* feedback,
+               uint32_t flags) {
+              auto self = reinterpret_cast<NativeWindowWaylandDmabuf*>(data);
+              self->pending_tranche_.scanout =
+                  flags & ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT;
+            },
+};
+
+const wl_buffer_listener NativeWindowWaylandDmabuf::kBufferListener = {
+    .release =
+        [](void* data, wl_buffer* wl_buffer) {
+          auto buffer = reinterpret_cast<Buffer*>(data);
+          buffer->busy = false;
+        },
+};
+
+NativeWindowWaylandDmabuf::NativeWindowWaylandDmabuf(
+    wl_display* display,
+    wl_compositor* compositor,
+    zwp_linux_dmabuf_v1* linux_dmabuf,
+    const size_t width,
+    const size_t height)
+    : NativeWindowWayland(compositor, 1, 1),
+      wl_display_(display),
+      linux_dmabuf_(linux_dmabuf),
+      format_(kPreferredFormats[0]) {
+  if (!valid_) {
+    return;
+  }
+  width_ = width;
+  height_ = height;
+
+  buffer_queue_ = wl_display_create_queue(wl_display_);
+  if (!buffer_queue_) {
+    ELINUX_LOG(ERROR) << "Failed to create the buffer event queue.";
+    valid_ = false;
+    return;
+  }
+
+  feedback_ =
+      zwp_linux_dmabuf_v1_get_surface_feedback(linux_dmabuf_, Surface());
+  zwp_linux_dmabuf_feedback_v1_add_listener(feedback_, &kFeedbackListener,
+                                            this);
+}
+
+NativeWindowWaylandDmabuf::~NativeWindowWaylandDmabuf() {
+  // The context has been destroyed with the render surface, and its GL
+  // objects with it.
+  for (auto& buffer : buffers_) {
+    DestroyBuffer(buffer.get(), false);
+  }
+  buffers_.clear();
+  for (auto& buffer : retired_buffers_) {
+    DestroyBuffer(buffer.get(), false);
+  }
+  retired_buffers_.clear();
+
+  if (buffer_queue_) {
+    wl_event_queue_destroy(buffer_queue_);
+    buffer_queue_ = nullptr;
+  }
+
+  if (feedback_) {
+    zwp_linux_dmabuf_feedback_v1_destroy(feedback_);
+    feedback_ = nullptr;
+  }
+
+  if (gbm_device_) {
+    gbm_device_destroy(gbm_device_);
+    gbm_device_ = nullptr;
+  }
+
+  if (drm_device_ != -1) {
+    close(drm_device_);
+    drm_device_ = -1;
+  }
+}
+
+bool NativeWindowWaylandDmabuf::Resize(const size_t width,
+                                       const size_t height) {
+  if (!valid_) {
+    ELINUX_LOG(ERROR) << "Failed to resize the window.";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  width_ = width;
+  height_ = height;
+  generation_++;
+  return true;
+}
+
+uint32_t NativeWindowWaylandDmabuf::Framebuffer() {
+  uint32_t width;
+  uint32_t height;
+  uint32_t format;
+  std::vector<uint64_t> modifiers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffers_generation_ != generation_) {
+      for (auto& buffer : buffers_) {
+        if (buffer->busy) {
+          RetireBuffer(std::move(buffer));
+        } else {
+          DestroyBuffer(buffer.get(), true);
+        }
+      }
+      buffers_.clear();
+      buffers_generation_ = generation_;
+    }
+    width = width_;
+    height = height_;
+    format = format_;
+    modifiers = modifiers_;
+  }
+
+  // Handle the releases received since the last frame.
+  wl_display_dispatch_queue_pending(wl_display_, buffer_queue_);
+  DestroyReleasedBuffers();
+
+  current_buffer_ = FindFreeBuffer();
+  if (!current_buffer_) {
+    if (buffers_.size() < kMaxBuffers) {
+      auto buffer = CreateBuffer(width, height, format, modifiers);
+      if (!buffer) {
+        return 0;
+      }
+      current_buffer_ = buffer.get();
+      buffers_.push_back(std::move(buffer));
+    } else {
+      // The compositor may be scanning out any of the buffers, so rendering
+      // into one of them is undefined.
+      current_buffer_ = WaitForFreeBuffer();
+      if (!current_buffer_) {
+        ELINUX_LOG(TRACE) << "No free dmabuf buffer, dropping the frame.";
+        return 0;
+      }
+    }
+  }
+
+  // Keeps the most recently used buffers at the end.
+  auto it = std::find_if(buffers_.begin(), buffers_.end(),
+                         [this](const std::unique_ptr<Buffer>& buffer) {
+                           return buffer.get() == current_buffer_;
+                         });
+  std::rotate(it, it + 1, buffers_.end());
+
+  return current_buffer_->framebuffer;
+}
+
+void NativeWindowWaylandDmabuf::SwapBuffers() {
+  if (!current_buffer_) {
+    return;
+  }
+
+  // The compositor waits for the rendering with the implicit fence of the
+  // dmabuf, so flushing is enough.
+  glFlush();
+
+  current_buffer_->busy = true;
+  wl_surface_attach(Surface(), current_buffer_->buffer, 0, 0);
+  wl_surface_damage(Surface(), 0, 0, INT32_MAX, INT32_MAX);
+  wl_surface_commit(Surface());
+  wl_display_flush(wl_display_);
+  current_buffer_ = nullptr;
+}
+
+NativeWindowWaylandDmabuf::Buffer* NativeWindowWaylandDmabuf::FindFreeBuffer()
+    const {
+  for (auto& buffer : buffers_) {
+    if (!buffer->busy) {
+      return buffer.get();
+    }
+  }
+  return nullptr;
+}
+
+NativeWindowWaylandDmabuf::Buffer*
+NativeWindowWaylandDmabuf::WaitForFreeBuffer() {
+  const auto deadline = std::chrono::steady_clock::now() + kReleaseTimeout;
+  Buffer* buffer;
+  while (!(buffer = FindFreeBuffer())) {
+    if (wl_display_prepare_read_queue(wl_display_, buffer_queue_) != 0) {
+      if (wl_display_dispatch_queue_pending(wl_display_, buffer_queue_) ==
+          -1) {
+        return nullptr;
+      }
+      continue;
+    }
+    wl_display_flush(wl_display_);
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    pollfd fd = {wl_display_get_fd(wl_display_), POLLIN, 0};
+    if (remaining.count() <= 0 ||
+        poll(&fd, 1, static_cast<int>(remaining.count())) <= 0) {
+      wl_display_cancel_read(wl_display_);
+      return nullptr;
+    }
+    if (wl_display_read_events(wl_display_) == -1 ||
+        wl_display_dispatch_queue_pending(wl_display_, buffer_queue_) == -1) {
+      return nullptr;
+    }
+  }
+  return buffer;
+}
+
+void NativeWindowWaylandDmabuf::RetireBuffer(std::unique_ptr<Buffer> buffer) {
+  // The compositor only uses the dmabuf, so the GL objects can go now.
+  DeleteGlObjects(buffer.get());
+  retired_buffers_.push_back(std::move(buffer));
+}
+
+void NativeWindowWaylandDmabuf::DestroyReleasedBuffers() {
+  for (auto it = retired_buffers_.begin(); it != retired_buffers_.end();) {
+    if ((*it)->busy) {
+      ++it;
+      continue;
+    }
+    DestroyBuffer(it->get(), false);
+    it = retired_buffers_.erase(it);
+  }
+}
+
+void NativeWindowWaylandDmabuf::OnFeedbackDone() {
+  uint32_t format = 0;
+  std::vector<uint64_t> modifiers;
+  bool scanout = false;
+
+  // The tranches are sent in the order of the compositor's preference.
+  for (const auto& tranche : pending_tranches_) {
+    for (auto candidate : kPreferredFormats) {
+      for (auto index : tranche.indices) {
+        if (index < format_table_.size() &&
+            format_table_[index].format == candidate) {
+          modifiers.push_back(format_table_[index].modifier);
+        }
+      }
+      if (!modifiers.empty()) {
+        format = candidate;
+        scanout = tranche.scanout;
+        break;
+      }
+    }
+    if (format) {
+      break;
+    }
+  }
+  pending_tranches_.clear();
+
+  if (!format) {
+    ELINUX_LOG(WARNING) << "The compositor doesn't support any dmabuf format "
+                           "for the window. Using the default one.";
+    format = kPreferredFormats[0];
+  }
+
+  // An invalid modifier stands for the driver's implicit layout, which
+  // gbm_bo_create() allocates.
+  auto has_implicit_modifier =
+      std::find(modifiers.begin(), modifiers.end(), DRM_FORMAT_MOD_INVALID) !=
+      modifiers.end();
+  if (has_implicit_modifier) {
+    modifiers.clear();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (format == format_ && modifiers == modifiers_) {
+    return;
+  }
+  ELINUX_LOG(INFO) << "dmabuf format: 0x" << std::hex << format << std::dec
+                   << ", modifiers: " << modifiers.size()
+                   << (scanout ? " (scanout)" : "");
+  format_ = format;
+  modifiers_ = std::move(modifiers);
+  generation_++;
+}
+
+bool NativeWindowWaylandDmabuf::OpenGbmDevice() {
+  std::string path = kFallbackRenderNode;
+  drmDevicePtr device = nullptr;
+  if (has_main_device_ &&
+      drmGetDeviceFromDevId(main_device_, 0, &device) == 0) {
+    if (device->available_nodes & (1 << DRM_NODE_RENDER)) {
+      path = device->nodes[DRM_NODE_RENDER];
+    }
+    drmFreeDevice(&device);
+  }
+
+  drm_device_ = open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (drm_device_ == -1) {
+    ELINUX_LOG(ERROR) << "Couldn't open " << path;
+    return false;
+  }
+
+  gbm_device_ = gbm_create_device(drm_device_);
+  if (!gbm_device_) {
+    ELINUX_LOG(ERROR) << "Couldn't create the GBM device.";
+    close(drm_device_);
+    drm_device_ = -1;
+    return false;
+  }
+  ELINUX_LOG(INFO) << "Allocating dmabuf buffers on " << path;
+  return true;
+}
+
+std::unique_ptr<NativeWindowWaylandDmabuf::Buffer>
+NativeWindowWaylandDmabuf::CreateBuffer(
+    uint32_t width,
+    uint32_t height,
+    uint32_t format,
+    const std::vector<uint64_t>& modifiers) {
+  const auto& egl = GetEglImageProcs();
+  if (!egl.eglCreateImageKHR || !egl.glEGLImageTargetRenderbufferStorageOES) {
+    ELINUX_LOG(ERROR) << "EGL images aren't supported.";
+    return nullptr;
+  }
+  if (!gbm_device_ && !OpenGbmDevice()) {
+    return nullptr;
+  }
+  egl_display_ = eglGetCurrentDisplay();
+
+  auto buffer = std::make_unique<Buffer>();
+  if (!modifiers.empty()) {
+    buffer->bo =
+        gbm_bo_create_with_modifiers(gbm_device_, width, height, format,
+                                     modifiers.data(), modifiers.size());
+  }
+  if (!buffer->bo) {
+    buffer->bo = gbm_bo_create(gbm_device_, width, height, format,
+                               GBM_BO_USE_RENDERING | GBM_BO_USE_SCANOUT);
+  }
+  if (!buffer->bo) {
+    ELINUX_LOG(ERROR) << "Failed to create a GBM buffer: " << width << "x"
+                      << height;
+    return nullptr;
+  }
+
+  const auto modifier = gbm_bo_get_modifier(buffer->bo);
+  const auto plane_count =
+      std::min<int>(gbm_bo_get_plane_count(buffer->bo), 4);
+  auto* params = zwp_linux_dmabuf_v1_create_params(linux_dmabuf_);
+  std::vector<EGLint> attributes = {
+      EGL_WIDTH,
+      static_cast<EGLint>(width),
+      EGL_HEIGHT,
+      static_cast<EGLint>(height),
+      EGL_LINUX_DRM_FOURCC_EXT,
+      static_cast<EGLint>(format),
+  };
+  std::vector<int> fds;
+  for (int i = 0; i < plane_count; i++) {
+    auto fd = gbm_bo_get_fd_for_plane(buffer->bo, i);
+    auto offset = gbm_bo_get_offset(buffer->bo, i);
+    auto stride = gbm_bo_get_stride_for_plane(buffer->bo, i);
+    fds.push_back(fd);
+    zwp_linux_buffer_params_v1_add(params, fd, i, offset, stride,
+                                   modifier >> 32, modifier & 0xffffffff);
+
+    attributes.insert(attributes.end(),
+                      {kPlaneAttributes[i][0], fd, kPlaneAttributes[i][1],
+                       static_cast<EGLint>(offset), kPlaneAttributes[i][2],
+                       static_cast<EGLint>(stride)});
+    if (modifier != DRM_FORMAT_MOD_INVALID) {
+      attributes.insert(
+          attributes.end(),
+          {kPlaneAttributes[i][3], static_cast<EGLint>(modifier & 0xffffffff),
+           kPlaneAttributes[i][4], static_cast<EGLint>(modifier >> 32)});
+    }
+  }
+  attributes.push_back(EGL_NONE);
+
+  buffer->buffer = zwp_linux_buffer_params_v1_create_immed(
+      params, width, height, format, 0);
+  zwp_linux_buffer_params_v1_destroy(params);
+  // The buffer isn't attached yet, so no release event can have been queued
+  // on the window's queue.
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(buffer->buffer),
+                     buffer_queue_);
+  wl_buffer_add_listener(buffer->buffer, &kBufferListener, buffer.get());
+
+  buffer->image =
+      egl.eglCreateImageKHR(egl_display_, EGL_NO_CONTEXT,
+                            EGL_LINUX_DMA_BUF_EXT, nullptr, attributes.data());
+  // Both the compositor and EGL hold their own references.
+  for (auto fd : fds) {
+    close(fd);
+  }
+  if (buffer->image == EGL_NO_IMAGE_KHR) {
+    ELINUX_LOG(ERROR) << "Failed to import the GBM buffer: "
+                      << get_egl_error_cause();
+    DestroyBuffer(buffer.get(), true);
+    return nullptr;
+  }
+
+  glGenRenderbuffers(1, &buffer->color_renderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, buffer->color_renderbuffer);
+  egl.glEGLImageTargetRenderbufferStorageOES(GL_RENDERBUFFER, buffer->image);
+
+  // The engine's renderer expects a stencil buffer as the window surface has.
+  glGenRenderbuffers(1, &buffer->stencil_renderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, buffer->stencil_renderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &buffer->framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, buffer->framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, buffer->color_renderbuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, buffer->stencil_renderbuffer);
+  auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    ELINUX_LOG(ERROR) << "The dmabuf framebuffer is incomplete: 0x" << std::hex
+                      << status;
+    DestroyBuffer(buffer.get(), true);
+    return nullptr;
+  }
+
+  return buffer;
+}
+
+void NativeWindowWaylandDmabuf::DeleteGlObjects(Buffer* buffer) {
+  if (buffer->framebuffer) {
+    glDeleteFramebuffers(1, &buffer->framebuffer);
+  }
+  if (buffer->stencil_renderbuffer) {
+    glDeleteRenderbuffers(1, &buffer->stencil_renderbuffer);
+  }
+  if (buffer->color_renderbuffer) {
+    glDeleteRenderbuffers(1, &buffer->color_renderbuffer);
+  }
+  buffer->framebuffer = 0;
+  buffer->stencil_renderbuffer = 0;
+  buffer->color_renderbuffer = 0;
+}
+
+void NativeWindowWaylandDmabuf::DestroyBuffer(Buffer* buffer,
+                                              bool delete_gl_objects) {
+  if (delete_gl_objects) {
+    DeleteGlObjects(buffer);
+  }
+  buffer->framebuffer = 0;
+  buffer->stencil_renderbuffer = 0;
+  buffer->color_renderbuffer = 0;
+
+  if (buffer->image != EGL_NO_IMAGE_KHR) {
+    GetEglImageProcs().eglDestroyImageKHR(egl_display_, buffer->image);
+    buffer->image = EGL_NO_IMAGE_KHR;
+  }
+
+  // The compositor keeps showing a destroyed buffer until the next one is
+  // attached.
+  if (buffer->buffer) {
+    wl_buffer_destroy(buffer->buffer);
+    buffer->buffer = nullptr;
+  }
+
+  if (buffer->bo) {
+    gbm_bo_destroy(buffer->bo);
+    buffer->bo = nullptr;
+  }
+}
+
+}  // namespace flutter
@@ -0,0 +1,143 @@
+// Copyright 2021 Sony Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_WINDOW_NATIVE_WINDOW_WAYLAND_DMABUF_H_
+#define FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_WINDOW_NATIVE_WINDOW_WAYLAND_DMABUF_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <gbm.h>
+#include <sys/types.h>
+#include <wayland-client.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "flutter/shell/platform/linux_embedded/window/native_window_wayland.h"
+
+// This header file is automatically generated by the wayland-scanner.
+extern "C" {
+#include "wayland/protocols/linux-dmabuf-unstable-v1-client-protocol.h"
+}
+
+namespace flutter {
+
+// A Wayland window whose frames are rendered into GBM buffers allocated by the
+// embedder instead of the buffers of wl_egl_window, and attached with
+// zwp_linux_dmabuf_v1. The format and the modifiers are chosen from the
+// compositor's dmabuf feedback for the surface, so that the compositor can
+// scan out the buffers without copying them.
+//
+// The EGL window surface of the base class is kept only to make the context
+// current. It is never swapped, so EGL doesn't attach its buffers.
+class NativeWindowWaylandDmabuf : public NativeWindowWayland {
+ public:
+  NativeWindowWaylandDmabuf(wl_display* display,
+                            wl_compositor* compositor,
+                            zwp_linux_dmabuf_v1* linux_dmabuf,
+                            const size_t width,
+                            const size_t height);
+  ~NativeWindowWaylandDmabuf();
+
+  // |NativeWindow|
+  bool Resize(const size_t width, const size_t height) override;
+
+  // |NativeWindow|
+  uint32_t Framebuffer() override;
+
+  // |NativeWindow|
+  bool RendersToFramebuffer() const override { return true; }
+
+  // |NativeWindow|
+  void SwapBuffers() override;
+
+ private:
+  struct Buffer {
+    gbm_bo* bo = nullptr;
+    wl_buffer* buffer = nullptr;
+    EGLImageKHR image = EGL_NO_IMAGE_KHR;
+    uint32_t color_renderbuffer = 0;
+    uint32_t stencil_renderbuffer = 0;
+    uint32_t framebuffer = 0;
+    // Set from the attach until the compositor releases the buffer.
+    bool busy = false;
+  };
+
+  struct FormatTableEntry {
+    uint32_t format;
+    uint32_t padding;
+    uint64_t modifier;
+  };
+
+  struct Tranche {
+    std::vector<uint16_t> indices;
+    bool scanout = false;
+  };
+
+  static const zwp_linux_dmabuf_feedback_v1_listener kFeedbackListener;
+  static const wl_buffer_listener kBufferListener;
+
+  // Picks the format and the modifiers from the received tranches.
+  void OnFeedbackDone();
+
+  bool OpenGbmDevice();
+
+  std::unique_ptr<Buffer> CreateBuffer(uint32_t width,
+                                       uint32_t height,
+                                       uint32_t format,
+                                       const std::vector<uint64_t>& modifiers);
+
+  // Returns a buffer which the compositor doesn't hold, or nullptr.
+  Buffer* FindFreeBuffer() const;
+
+  // Dispatches the buffer release events until a buffer is free or
+  // |kReleaseTimeout| has passed. Returns the free buffer, or nullptr.
+  Buffer* WaitForFreeBuffer();
+
+  // Keeps |buffer|, which the compositor still holds, until it's released.
+  void RetireBuffer(std::unique_ptr<Buffer> buffer);
+
+  // Destroys the retired buffers which the compositor has released.
+  void DestroyReleasedBuffers();
+
+  // GL objects can only be deleted with the context current.
+  void DeleteGlObjects(Buffer* buffer);
+  void DestroyBuffer(Buffer* buffer, bool delete_gl_objects);
+
+  wl_display* wl_display_;
+  // The release events of the buffers are dispatched on the raster thread
+  // from this queue, so that it can wait for them.
+  wl_event_queue* buffer_queue_ = nullptr;
+  zwp_linux_dmabuf_v1* linux_dmabuf_;
+  zwp_linux_dmabuf_feedback_v1* feedback_ = nullptr;
+
+  // The feedback being received. Only used on the platform thread.
+  std::vector<FormatTableEntry> format_table_;
+  std::vector<Tranche> pending_tranches_;
+  Tranche pending_tranche_;
+  dev_t main_device_ = 0;
+  bool has_main_device_ = false;
+
+  // The buffer configuration, which is updated on the platform thread and
+  // read on the raster thread. |generation_| is bumped for each change.
+  std::mutex mutex_;
+  uint32_t format_;
+  std::vector<uint64_t> modifiers_;
+  uint32_t generation_ = 1;
+
+  // Only used on the raster thread.
+  int drm_device_ = -1;
+  gbm_device* gbm_device_ = nullptr;
+  EGLDisplay egl_display_ = EGL_NO_DISPLAY;
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+  // Buffers of a previous configuration which the compositor still holds.
+  std::vector<std::unique_ptr<Buffer>> retired_buffers_;
+  uint32_t buffers_generation_ = 0;
+  Buffer* current_buffer_ = nullptr;
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_PLATFORM_LINUX_EMBEDDED_WINDOW_NATIVE_WINDOW_WAYLAND_DMABUF_H_
@@ -7,9 +7,14 @@
 
 #include <string>
 #include <variant>
+#include <vector>
 
 #include "flutter/shell/platform/linux_embedded/public/flutter_elinux.h"
+#if defined(USE_VULKAN)
+#include "flutter/shell/platform/linux_embedded/surface/surface_vulkan.h"
+#else
 #include "flutter/shell/platform/linux_embedded/surface/surface_gl.h"
+#endif
 #include "flutter/shell/platform/linux_embedded/window_binding_handler_delegate.h"
 
 namespace flutter {
@@ -22,7 +27,11 @@ struct PhysicalWindowBounds {
   size_t height;
 };
 
+#if defined(USE_VULKAN)
+using ELinuxRenderSurfaceTarget = SurfaceVulkan;
+#else
 using ELinuxRenderSurfaceTarget = SurfaceGl;
+#endif
 
 // Abstract class for binding Linux embedded platform windows to Flutter views.
 class WindowBindingHandler {
@@ -33,6 +42,10 @@ class WindowBindingHandler {
   // you have to call this every time in the main loop.
   virtual bool DispatchEvent() = 0;
 
+  // Returns the file descriptors which become readable when DispatchEvent()
+  // has events to handle.
+  virtual std::vector<int> GetPollFds() const = 0;
+
   // Create a surface.
   virtual bool CreateRenderSurface(int32_t width, int32_t height) = 0;
 
@@ -50,6 +63,10 @@ class WindowBindingHandler {
   // Returns the rotation(degree) for the backing window.
   virtual uint16_t GetRotationDegree() const = 0;
 
+  // Returns true if the display applies the rotation to the rendered frames.
+  // In that case, the frames are rendered unrotated.
+  virtual bool IsRotationAppliedByDisplay() const = 0;
+
   // Returns the scale factor for the backing window.
   virtual double GetDpiScale() = 0;
 
@@ -67,6 +84,12 @@ class WindowBindingHandler {
   // shown by Flutter events.
   virtual void UpdateVirtualKeyboardStatus(const bool show) = 0;
 
+  // Sets the text around the cursor of the text being edited, which input
+  // methods use as context. |cursor| and |anchor| are byte offsets in |text|.
+  virtual void UpdateVirtualKeyboardSurroundingText(const std::string& text,
+                                                    size_t cursor,
+                                                    size_t anchor) = 0;
+
   // Returns the clipboard data.
   virtual std::string GetClipboardData() = 0;
 
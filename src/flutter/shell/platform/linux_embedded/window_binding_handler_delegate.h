@@ -15,6 +15,11 @@ class WindowBindingHandlerDelegate {
   // Typically called by currently configured WindowBindingHandler
   virtual void OnWindowSizeChanged(size_t width, size_t height) const = 0;
 
+  // Notifies delegate that the refresh rate of the display has changed, e.g.
+  // because another display has been plugged in.
+  // Typically called by currently configured WindowBindingHandler
+  virtual void OnDisplayChanged() = 0;
+
   // Notifies delegate that backing window mouse has moved.
   // Typically called by currently configured WindowBindingHandler
   virtual void OnPointerMove(double x, double y) = 0;
@@ -84,6 +89,12 @@ class WindowBindingHandlerDelegate {
   // Typically called by currently configured WindowBindingHandler
   virtual void OnVirtualSpecialKey(uint32_t keycode) = 0;
 
+  // Notifies delegate that the input method deletes |count| code points
+  // starting |offset_from_cursor| code points past the cursor.
+  // Typically called by currently configured WindowBindingHandler
+  virtual void OnVirtualDeleteSurroundingText(int offset_from_cursor,
+                                              int count) = 0;
+
   // Notifies delegate that backing window size has recevied scroll.
   // Typically called by currently configured WindowBindingHandler
   virtual void OnScroll(double x,
@@ -96,6 +107,10 @@ class WindowBindingHandlerDelegate {
   // Typically called by currently configured WindowBindingHandler
   virtual void OnVsync(uint64_t last_frame_time_nanos,
                        uint64_t vsync_interval_time_nanos) = 0;
+
+  // Notifies delegate that backing window display has been turned off or on,
+  // e.g. by the idle display blanking.
+  virtual void OnDisplayPowerChanged(bool power_on) = 0;
 };
 
 }  // namespace flutter